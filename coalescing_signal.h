@@ -0,0 +1,313 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "signals.h"
+
+namespace signals
+{
+
+// how a coalescing_signal folds an emission into the one already pending for its key
+namespace coalesce
+{
+
+// the arguments of the latest emission replace the pending ones
+struct last_value
+{};
+
+// pending keys are kept in a hash map and flushed in the order they were first emitted
+struct hashed_keys
+{};
+
+/* integral keys in [0, MaxKey) are kept in a bitset, with their values at the key's
+ * position, and flushed in key order. memory and the scan of every flush grow with MaxKey,
+ * other keys are kept hashed and flushed after them */
+template <std::size_t MaxKey>
+struct dense_keys
+{};
+
+}
+
+namespace detail
+{
+
+inline unsigned lowest_bit(std::uint64_t w) noexcept
+{
+#if defined(__GNUC__)
+    return unsigned(__builtin_ctzll(w));
+#else
+    unsigned i = 0;
+    while ((w & 1) == 0)
+    {
+        w >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
+// pending emissions of any hashable key, flushed in the order of their first emission
+template <typename Key, typename Values>
+struct hashed_pending
+{
+    std::unordered_map<Key, std::size_t> index;
+    std::vector<std::pair<Key, Values>> entries;
+
+    std::size_t size() const noexcept
+    {
+        return entries.size();
+    }
+
+    Values* find(Key const& key)
+    {
+        auto it = index.find(key);
+        if (it == index.end())
+            return nullptr;
+        return &entries[it->second].second;
+    }
+
+    void add(Key const& key, Values&& v)
+    {
+        entries.emplace_back(key, std::move(v));
+        try
+        {
+            index.emplace(key, entries.size() - 1);
+        }
+        catch (...)
+        {
+            entries.pop_back();
+            throw;
+        }
+    }
+
+    template <typename Visit>
+    std::size_t drain(Visit&& visit)
+    {
+        auto taken = std::move(entries);
+        entries.clear();
+        index.clear();
+        for (auto& e : taken)
+            visit(e.first, std::move(e.second));
+        auto n = taken.size();
+        if (entries.empty())
+        {
+            taken.clear();
+            entries = std::move(taken);
+        }
+        return n;
+    }
+};
+
+/* pending emissions of integral keys below MaxKey, a bitset with one bit per key and the
+ * values stored at the key's position, flushed in key order. the other keys go to a
+ * hashed_pending flushed after them */
+template <typename Key, typename Values, std::size_t MaxKey>
+struct dense_pending
+{
+    static constexpr bool has_values = std::tuple_size_v<Values> != 0;
+
+    std::vector<std::uint64_t> bits;
+    std::vector<std::optional<Values>> values;
+    std::size_t count = 0;
+    hashed_pending<Key, Values> others;
+
+    std::size_t size() const noexcept
+    {
+        return count + others.size();
+    }
+
+    static bool dense(Key key) noexcept
+    {
+        if constexpr (std::is_signed_v<Key>)
+        {
+            if (key < 0)
+                return false;
+        }
+        return std::uintmax_t(key) < MaxKey;
+    }
+
+    Values* find(Key key)
+    {
+        if (!dense(key))
+            return others.find(key);
+        auto i = std::size_t(key);
+        if (i / 64 >= bits.size() || (bits[i / 64] >> i % 64 & 1) == 0)
+            return nullptr;
+        if constexpr (has_values)
+            return &*values[i];
+        else
+        {
+            static Values none;
+            return &none;
+        }
+    }
+
+    void add(Key key, Values&& v)
+    {
+        if (!dense(key))
+        {
+            others.add(key, std::move(v));
+            return;
+        }
+        auto i = std::size_t(key);
+        if (i / 64 >= bits.size())
+            bits.resize(i / 64 + 1);
+        if constexpr (has_values)
+        {
+            if (i >= values.size())
+                values.resize(i + 1);
+            values[i].emplace(std::move(v));
+        }
+        bits[i / 64] |= std::uint64_t(1) << i % 64;
+        count++;
+    }
+
+    // takes what is pending, visit may record new emissions, they are kept for the next drain
+    template <typename Visit>
+    std::size_t drain(Visit&& visit)
+    {
+        auto taken_bits = std::move(bits);
+        auto taken_values = std::move(values);
+        auto taken_others = std::move(others);
+        auto n = std::exchange(count, 0);
+        bits.clear();
+        values.clear();
+        others = hashed_pending<Key, Values>();
+        for (std::size_t w = 0; w < taken_bits.size(); w++)
+        {
+            while (taken_bits[w] != 0)
+            {
+                auto i = w * 64 + lowest_bit(taken_bits[w]);
+                taken_bits[w] &= taken_bits[w] - 1;
+                if constexpr (has_values)
+                {
+                    auto v = std::move(*taken_values[i]);
+                    taken_values[i].reset();
+                    visit(Key(i), std::move(v));
+                }
+                else
+                    visit(Key(i), Values());
+            }
+        }
+        n += taken_others.drain(visit);
+        // nothing was recorded meanwhile, keep the storage for the next round
+        if (bits.empty())
+        {
+            bits = std::move(taken_bits);
+            values = std::move(taken_values);
+        }
+        if (others.size() == 0)
+            others = std::move(taken_others);
+        return n;
+    }
+};
+
+template <typename Key, typename Values, typename Keys>
+struct pending_for
+{
+    using type = hashed_pending<Key, Values>;
+};
+
+template <typename Key, typename Values, std::size_t MaxKey>
+struct pending_for<Key, Values, coalesce::dense_keys<MaxKey>>
+{
+    static_assert(std::is_integral_v<Key>, "dense keys have to be integral");
+    using type = dense_pending<Key, Values, MaxKey>;
+};
+
+
+}
+
+template <typename T, typename Merge = coalesce::last_value, typename Keys = coalesce::hashed_keys,
+          std::size_t InlineBytes = default_inline_bytes, typename Policy = default_policy>
+struct coalescing_signal;
+
+/* signal whose emissions are recorded and delivered once per key by flush()
+ *
+ * the first argument is the key. an emission for a key that is already pending is folded
+ * into the pending one, with coalesce::last_value the newer arguments win, otherwise
+ * merge(pending..., new...) is called with the pending arguments by reference.
+ * keys are tracked in a hash map and flushed in the order they were first emitted, with
+ * coalesce::dense_keys<MaxKey> small integral keys are tracked in a bitset instead.
+ * slots connect to the target() signal that flush() emits, emissions made while
+ * flushing wait for the next flush. an exception from a slot drops the rest of that flush */
+template <typename Key, typename... Args, typename Merge, typename Keys, std::size_t InlineBytes, typename Policy>
+struct coalescing_signal<void (Key, Args...), Merge, Keys, InlineBytes, Policy>
+{
+    using signal_type = signal<void (Key, Args...), InlineBytes, Policy>;
+    using values_type = std::tuple<std::decay_t<Args>...>;
+private:
+    using key_type = std::decay_t<Key>;
+    using pending_type = typename detail::pending_for<key_type, values_type, Keys>::type;
+
+    signal_type sig;
+    pending_type pending;
+    slot<void ()> wakeup;
+    Merge merge;
+public:
+    coalescing_signal() = default;
+
+    explicit coalescing_signal(Merge merge)
+    : merge(std::move(merge))
+    {}
+
+    coalescing_signal(coalescing_signal const&) = delete;
+    coalescing_signal& operator=(coalescing_signal const&) = delete;
+
+    signal_type& target() noexcept
+    {
+        return sig;
+    }
+
+    template <typename F>
+    typename signal_type::connection connect(F&& f)
+    {
+        return sig.connect(std::forward<F>(f));
+    }
+
+    /* f is called whenever an emission is recorded while nothing is pending,
+     * an event loop can use it to run flush() at the end of its iteration */
+    template <typename F>
+    void on_pending(F&& f)
+    {
+        wakeup = slot<void ()>(std::forward<F>(f));
+    }
+
+    void operator()(arg_ref<Key> key, arg_ref<Args>... a)
+    {
+        if (auto* held = pending.find(key))
+        {
+            if constexpr (std::is_same_v<Merge, coalesce::last_value>)
+                *held = values_type(a...);
+            else
+                std::apply([&](auto&... h) { merge(h..., a...); }, *held);
+            return;
+        }
+        pending.add(key, values_type(a...));
+        if (pending_count() == 1 && wakeup)
+            wakeup();
+    }
+
+    std::size_t pending_count() const noexcept
+    {
+        return pending.size();
+    }
+
+    // emits every pending key once, returns how many were emitted
+    std::size_t flush()
+    {
+        return pending.drain([&](key_type const& key, values_type&& v)
+        {
+            std::apply([&](auto&... held) { sig(key, held...); }, v);
+        });
+    }
+};
+
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+/* reductions of slot results for signal<R(Args...)>
+ * a combiner is fed every result in emission order through operator(), returning false
+ * stops the emission right there, result() is what the emit returns */
+namespace signals::combiners
+{
+
+template <typename R>
+struct optional_last_value
+{
+    std::optional<R> last;
+
+    bool operator()(R&& r)
+    {
+        last = std::forward<R>(r);
+        return true;
+    }
+    std::optional<R> result()
+    {
+        return std::move(last);
+    }
+};
+
+// first result that converts to true, for pointers and optionals
+template <typename R>
+struct first_non_null
+{
+    R value{};
+
+    bool operator()(R&& r)
+    {
+        if (!r)
+            return true;
+        value = std::forward<R>(r);
+        return false;
+    }
+    R result()
+    {
+        return std::move(value);
+    }
+};
+
+template <typename R>
+struct sum
+{
+    R value{};
+
+    bool operator()(R&& r)
+    {
+        value += r;
+        return true;
+    }
+    R result()
+    {
+        return std::move(value);
+    }
+};
+
+template <typename R>
+struct minimum
+{
+    std::optional<R> value;
+
+    bool operator()(R&& r)
+    {
+        if (!value || r < *value)
+            value = std::forward<R>(r);
+        return true;
+    }
+    std::optional<R> result()
+    {
+        return std::move(value);
+    }
+};
+
+template <typename R>
+struct maximum
+{
+    std::optional<R> value;
+
+    bool operator()(R&& r)
+    {
+        if (!value || *value < r)
+            value = std::forward<R>(r);
+        return true;
+    }
+    std::optional<R> result()
+    {
+        return std::move(value);
+    }
+};
+
+// stops at the first true result
+template <typename R>
+struct any_of
+{
+    bool value = false;
+
+    bool operator()(R&& r)
+    {
+        value = static_cast<bool>(r);
+        return !value;
+    }
+    bool result() const
+    {
+        return value;
+    }
+};
+
+// stops at the first false result
+template <typename R>
+struct all_of
+{
+    bool value = true;
+
+    bool operator()(R&& r)
+    {
+        value = static_cast<bool>(r);
+        return value;
+    }
+    bool result() const
+    {
+        return value;
+    }
+};
+
+// writes results into a caller owned buffer, stops once it is full, result() is the count written
+template <typename R>
+struct collect_into
+{
+    R* first;
+    std::size_t capacity;
+    std::size_t count = 0;
+
+    collect_into(R* first, std::size_t capacity) noexcept
+    : first(first)
+    , capacity(capacity)
+    {}
+
+    bool operator()(R&& r)
+    {
+        if (count == capacity)
+            return false;
+        first[count++] = std::forward<R>(r);
+        return count != capacity;
+    }
+    std::size_t result() const
+    {
+        return count;
+    }
+};
+
+}
@@ -0,0 +1,303 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "slot.h"
+#include "work_stealing_pool.h"
+
+namespace signals
+{
+
+template <typename T, std::size_t InlineBytes = default_inline_bytes>
+struct concurrent_signal;
+
+/* signal that may be emitted from any number of threads while others connect and disconnect
+ *
+ * emitters never lock: they register in one of two epoch counters and walk an immutable
+ * snapshot of the slot list. writers are serialized by a mutex, publish a new snapshot
+ * and, once they let go of it, wait until every emitter registered in the previous epoch
+ * is gone before reclaiming the old one.
+ *
+ * disconnect() returns only after every invocation of the slot that might have started
+ * before it has finished. when called from a slot of the same signal it can not wait for
+ * its own thread, so it only guarantees that no new invocation starts, reclamation
+ * is then left to the next writer.
+ *
+ * the callables are invoked concurrently and have to be thread safe themselves.
+ * the signal must outlive all emissions, connections may outlive the signal */
+template <typename... Args, std::size_t InlineBytes>
+struct concurrent_signal<void (Args...), InlineBytes>
+{
+    using slot_type = slot<void (Args...), InlineBytes>;
+    struct connection;
+
+private:
+    struct node
+    {
+        slot_type slot;
+        std::atomic<bool> active{true};
+        concurrent_signal* parent;
+
+        node(slot_type&& slot, concurrent_signal* parent) noexcept
+        : slot(std::move(slot))
+        , parent(parent)
+        {}
+    };
+
+    struct snapshot
+    {
+        std::vector<node*> nodes;
+    };
+
+    struct alignas(64) epoch_counter
+    {
+        std::atomic<std::size_t> value{0};
+    };
+
+    // marks the thread as running slots of sig, writers on it must not wait for readers
+    struct reading_mark
+    {
+        concurrent_signal* sig;
+        reading_mark* prev;
+
+        explicit reading_mark(concurrent_signal* sig) noexcept
+        : sig(sig)
+        , prev(reading)
+        {
+            reading = this;
+        }
+        ~reading_mark()
+        {
+            reading = prev;
+        }
+
+        reading_mark(reading_mark const&) = delete;
+        reading_mark& operator=(reading_mark const&) = delete;
+    };
+
+    struct read_guard
+    {
+        concurrent_signal* sig;
+        epoch_counter* counter;
+
+        explicit read_guard(concurrent_signal* sig) noexcept
+        : sig(sig)
+        {
+            for (;;)
+            {
+                auto e = sig->epoch.load();
+                counter = &sig->readers[e & 1];
+                counter->value.fetch_add(1);
+                // a writer flipped the epoch in between, it may not wait for this counter
+                if (sig->epoch.load() == e)
+                    break;
+                counter->value.fetch_sub(1);
+            }
+        }
+        ~read_guard()
+        {
+            counter->value.fetch_sub(1, std::memory_order_release);
+        }
+
+        read_guard(read_guard const&) = delete;
+        read_guard& operator=(read_guard const&) = delete;
+    };
+
+    static inline thread_local reading_mark* reading = nullptr;
+
+    std::atomic<snapshot*> current{nullptr};
+    std::atomic<std::size_t> epoch{0};
+    epoch_counter readers[2];
+
+    std::mutex writer;
+    // serializes the grace periods, which are waited for without writer
+    std::mutex grace;
+    std::vector<snapshot*> retired;
+    std::vector<node*> retired_nodes;
+
+    bool emitting_on_this_thread() const noexcept
+    {
+        for (auto* g = reading; g != nullptr; g = g->prev)
+            if (g->sig == this)
+                return true;
+        return false;
+    }
+
+    /* takes what is retired so far, releases writer and waits for every emitter that could
+     * have seen it. a slot of one of those emitters may be waiting for writer itself */
+    void synchronize(std::unique_lock<std::mutex>& lock) noexcept
+    {
+        std::vector<snapshot*> snapshots;
+        std::vector<node*> nodes;
+        snapshots.swap(retired);
+        nodes.swap(retired_nodes);
+        lock.unlock();
+
+        {
+            std::lock_guard<std::mutex> period(grace);
+            auto old = epoch.fetch_add(1);
+            auto& counter = readers[old & 1].value;
+            while (counter.load(std::memory_order_acquire) != 0)
+                std::this_thread::yield();
+        }
+
+        for (auto* s : snapshots)
+            delete s;
+        for (auto* n : nodes)
+            delete n;
+    }
+
+    void publish(snapshot* next) noexcept
+    {
+        auto* prev = current.exchange(next);
+        if (prev != nullptr)
+            retired.push_back(prev);
+    }
+
+    node* add(slot_type&& slot)
+    {
+        std::unique_lock<std::mutex> lock(writer);
+        auto* n = new node(std::move(slot), this);
+        auto* next = new snapshot();
+        auto* prev = current.load();
+        next->nodes.reserve(prev == nullptr ? 1 : prev->nodes.size() + 1);
+        next->nodes.push_back(n);
+        if (prev != nullptr)
+            next->nodes.insert(next->nodes.end(), prev->nodes.begin(), prev->nodes.end());
+        publish(next);
+        if (retired.size() > 8 && !emitting_on_this_thread())
+            synchronize(lock);
+        return n;
+    }
+
+    void remove(node* n)
+    {
+        std::unique_lock<std::mutex> lock(writer);
+        n->active.store(false);
+        auto* prev = current.load();
+        auto* next = new snapshot();
+        next->nodes.reserve(prev->nodes.size() - 1);
+        for (auto* a : prev->nodes)
+            if (a != n)
+                next->nodes.push_back(a);
+        publish(next);
+        retired_nodes.push_back(n);
+        if (!emitting_on_this_thread())
+            synchronize(lock);
+    }
+
+public:
+    struct connection
+    {
+    private:
+        friend concurrent_signal;
+        node* n = nullptr;
+
+        explicit connection(node* n) noexcept
+        : n(n)
+        {}
+    public:
+        connection() = default;
+        ~connection()
+        {
+            disconnect();
+        }
+
+        void disconnect()
+        {
+            if (n == nullptr)
+                return;
+            auto* cur = std::exchange(n, nullptr);
+            if (cur->parent != nullptr)
+                cur->parent->remove(cur);
+            else
+                delete cur;
+        }
+
+        connection(connection const&) = delete;
+        connection(connection&& r) noexcept
+        : n(std::exchange(r.n, nullptr))
+        {}
+
+        connection& operator=(connection const&) = delete;
+        connection& operator=(connection&& r) noexcept
+        {
+            if (this == &r)
+                return *this;
+            disconnect();
+            n = std::exchange(r.n, nullptr);
+            return *this;
+        }
+    };
+
+    concurrent_signal() = default;
+
+    concurrent_signal(concurrent_signal const&) = delete;
+    concurrent_signal(concurrent_signal&&) = delete;
+    concurrent_signal& operator=(concurrent_signal const&) = delete;
+    concurrent_signal& operator=(concurrent_signal&&) = delete;
+
+    ~concurrent_signal()
+    {
+        std::lock_guard<std::mutex> lock(writer);
+        auto* s = current.exchange(nullptr);
+        if (s != nullptr)
+        {
+            // live connections now own their nodes
+            for (auto* n : s->nodes)
+                n->parent = nullptr;
+            delete s;
+        }
+        for (auto* r : retired)
+            delete r;
+        for (auto* n : retired_nodes)
+            delete n;
+    }
+
+    connection connect(slot_type slot)
+    {
+        return connection(add(std::move(slot)));
+    }
+
+    // slots run newest first, as in signal
+    void operator()(arg_ref<Args>... a)
+    {
+        read_guard guard(this);
+        reading_mark mark(this);
+        auto* s = current.load();
+        if (s == nullptr)
+            return;
+        for (auto* n : s->nodes)
+            if (n->active.load(std::memory_order_acquire))
+                n->slot(a...);
+    }
+
+    /* invokes the slots of one snapshot spread over the threads of pool and returns
+     * once all of them are done. the snapshot is protected by the calling thread's
+     * registration, so the disconnect guarantee holds for the pool threads too. they are
+     * marked as emitting, a slot disconnecting on one of them does not wait for the
+     * emission it runs in. slots must not throw */
+    void emit_parallel(work_stealing_pool& pool, arg_ref<Args>... a)
+    {
+        read_guard guard(this);
+        reading_mark mark(this);
+        auto* s = current.load();
+        if (s == nullptr)
+            return;
+        auto invoke = [&](std::size_t i)
+        {
+            reading_mark worker_mark(this);
+            auto* n = s->nodes[i];
+            if (n->active.load(std::memory_order_acquire))
+                n->slot(a...);
+        };
+        pool.run(s->nodes.size(), invoke);
+    }
+};
+
+}
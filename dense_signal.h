@@ -0,0 +1,246 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "slot.h"
+
+namespace signals
+{
+
+template <typename T, std::size_t InlineBytes = default_inline_bytes>
+struct dense_signal;
+
+/* signal keeping its slots in one array, emit is a linear scan
+ * slots disconnected while emitting are left as tombstones and slots connected
+ * while emitting are parked aside, both are folded in once the outermost emit returns.
+ * as in signal, a slot connected while emitting misses the running emissions but not
+ * the ones nested in them */
+template <typename... Args, std::size_t InlineBytes>
+struct dense_signal<void (Args...), InlineBytes>
+{
+    using slot_type = slot<void (Args...), InlineBytes>;
+    struct connection;
+
+private:
+    struct entry
+    {
+        slot_type slot;
+        connection* owner;
+    };
+
+    // separate from the signal so that destroying it in emit leaves running slots alive
+    struct state
+    {
+        std::vector<entry> entries;
+        // a deque, so that connecting leaves the parked slots a nested emit runs in place
+        std::deque<entry> pending;
+        std::size_t tombstones = 0;
+        std::size_t depth = 0;
+        bool orphaned = false;
+
+        entry& at(std::size_t index) noexcept
+        {
+            return index < entries.size() ? entries[index] : pending[index - entries.size()];
+        }
+
+        void detach_all() noexcept
+        {
+            for (auto& e : entries)
+                if (e.owner != nullptr)
+                    e.owner->parent = nullptr;
+            for (auto& e : pending)
+                if (e.owner != nullptr)
+                    e.owner->parent = nullptr;
+        }
+
+        void compact() noexcept
+        {
+            if (tombstones != 0)
+            {
+                std::size_t to = 0;
+                for (std::size_t from = 0; from < entries.size(); from++)
+                {
+                    if (entries[from].owner == nullptr)
+                        continue;
+                    if (to != from)
+                        entries[to] = std::move(entries[from]);
+                    entries[to].owner->index = to;
+                    to++;
+                }
+                entries.erase(entries.begin() + to, entries.end());
+                tombstones = 0;
+            }
+            if (pending.empty())
+                return;
+            try
+            {
+                entries.reserve(entries.size() + pending.size());
+            }
+            catch (...)
+            {
+                // out of memory, the slots stay parked and the next compact tries again
+                for (std::size_t i = 0; i < pending.size(); i++)
+                    if (pending[i].owner != nullptr)
+                        pending[i].owner->index = entries.size() + i;
+                return;
+            }
+            for (auto& e : pending)
+            {
+                if (e.owner == nullptr)
+                    continue;
+                e.owner->index = entries.size();
+                entries.push_back(std::move(e));
+            }
+            pending.clear();
+        }
+    };
+
+    struct emit_guard
+    {
+        state* s;
+
+        explicit emit_guard(state* s) noexcept
+        : s(s)
+        {
+            ++s->depth;
+        }
+        ~emit_guard()
+        {
+            if (--s->depth != 0)
+                return;
+            if (s->orphaned)
+            {
+                s->detach_all();
+                delete s;
+            }
+            else
+                s->compact();
+        }
+    };
+
+    state* st = new state();
+
+public:
+    struct connection
+    {
+    private:
+        friend dense_signal;
+
+        state* parent = nullptr;
+        std::size_t index = 0;
+
+        connection(state* parent, std::size_t index) noexcept
+        : parent(parent)
+        , index(index)
+        {
+            parent->at(index).owner = this;
+        }
+
+        void steal(connection& r) noexcept
+        {
+            parent = r.parent;
+            index = r.index;
+            r.parent = nullptr;
+            if (parent != nullptr)
+                parent->at(index).owner = this;
+        }
+    public:
+        connection() = default;
+        ~connection()
+        {
+            disconnect();
+        }
+
+        void disconnect() noexcept
+        {
+            if (parent == nullptr)
+                return;
+            auto* s = parent;
+            parent = nullptr;
+            s->at(index).owner = nullptr;
+            if (s->depth != 0)
+            {
+                // the slot may be running right now, keep it until the emit is done
+                if (index < s->entries.size())
+                    s->tombstones++;
+                return;
+            }
+            s->at(index).slot.reset();
+            if (index < s->entries.size())
+                s->tombstones++;
+            if (s->tombstones * 2 > s->entries.size())
+                s->compact();
+        }
+
+        connection(connection const&) = delete;
+        connection(connection&& r) noexcept
+        {
+            steal(r);
+        }
+
+        connection& operator=(connection const&) = delete;
+        connection& operator=(connection&& r) noexcept
+        {
+            if (this == &r)
+                return *this;
+            disconnect();
+            steal(r);
+            return *this;
+        }
+    };
+
+    dense_signal() = default;
+
+    dense_signal(dense_signal const&) = delete;
+    dense_signal(dense_signal&&) = delete;
+    dense_signal& operator=(dense_signal const&) = delete;
+    dense_signal& operator=(dense_signal&&) = delete;
+
+    ~dense_signal()
+    {
+        if (st->depth != 0)
+        {
+            st->orphaned = true;
+            return;
+        }
+        st->detach_all();
+        delete st;
+    }
+
+    connection connect(slot_type slot)
+    {
+        // behind slots still parked, so that their indices hold
+        if (st->depth == 0 && st->pending.empty())
+            st->entries.push_back(entry{std::move(slot), nullptr});
+        else
+            st->pending.push_back(entry{std::move(slot), nullptr});
+        return connection(st, st->entries.size() + st->pending.size() - 1);
+    }
+
+    // slots run newest first, as in signal
+    void operator()(arg_ref<Args>... a)
+    {
+        auto* s = st;
+        if (s->entries.empty() && s->pending.empty())
+            return;
+        emit_guard guard(s);
+
+        for (std::size_t i = s->pending.size(); i-- > 0 && !s->orphaned;)
+        {
+            auto& e = s->pending[i];
+            if (e.owner != nullptr)
+                e.slot(a...);
+        }
+        for (std::size_t i = s->entries.size(); i-- > 0 && !s->orphaned;)
+        {
+            auto& e = s->entries[i];
+            if (e.owner != nullptr)
+                e.slot(a...);
+        }
+    }
+};
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// linux only: sleeping on a 32 bit atomic, also across processes when it is in shared memory
+namespace signals
+{
+namespace detail
+{
+
+// returns at once unless word holds expected, may also return spuriously
+inline void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected, timespec const* timeout = nullptr) noexcept
+{
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT, expected, timeout, nullptr, 0);
+}
+
+inline void futex_wake_all(std::atomic<std::uint32_t>& word) noexcept
+{
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+}
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/* what a signal reports about its emissions, selected by Policy::instrumentation
+ * a signal derives from it and calls
+ *   on_emit()                       once per emission, empty or not, the object it returns
+ *                                   is kept until the emission returns, even if the signal dies
+ *   on_slot_begin(slot) / on_slot_end(token)
+ *                                   around every slot invocation, slot identifies the connection.
+ *                                   end is skipped if the signal was destroyed by the slot
+ *   on_disconnect_in_emit()         when a connection an emission is on gets disconnected
+ *   on_move_in_emit()               when a connection an emission is on gets moved */
+namespace signals
+{
+
+// every hook is empty and the base takes no space, the default
+struct no_instrumentation
+{
+    struct emit_scope
+    {};
+    struct token
+    {};
+
+    emit_scope on_emit() noexcept
+    {
+        return {};
+    }
+    token on_slot_begin(void const*) noexcept
+    {
+        return {};
+    }
+    void on_slot_end(token) noexcept
+    {}
+    void on_disconnect_in_emit() noexcept
+    {}
+    void on_move_in_emit() noexcept
+    {}
+};
+
+/* counters and a slot latency histogram
+ *
+ * only the thread emitting the signal writes them, so they are updated with plain relaxed
+ * loads and stores instead of read-modify-writes, and any other thread may take a
+ * snapshot() at any time without locking. the histogram is log-linear like HDR histograms,
+ * eight linear buckets per power of two of nanoseconds, so the error is below 12.5% */
+struct counting_instrumentation
+{
+    static constexpr std::size_t sub_buckets = 8;
+    static constexpr std::size_t buckets = (64 - 2) * sub_buckets;
+
+    // smallest latency in nanoseconds counted by bucket i
+    static constexpr std::uint64_t bucket_lower_bound(std::size_t i) noexcept
+    {
+        if (i < sub_buckets)
+            return i;
+        return (sub_buckets + i % sub_buckets) << (i / sub_buckets - 1);
+    }
+
+    static constexpr std::size_t bucket_of(std::uint64_t ns) noexcept
+    {
+        if (ns < sub_buckets)
+            return std::size_t(ns);
+        std::size_t magnitude = 63;
+        while ((ns >> magnitude) == 0)
+            magnitude--;
+        return (magnitude - 2) * sub_buckets + std::size_t(ns >> (magnitude - 3)) % sub_buckets;
+    }
+
+    struct snapshot_type
+    {
+        std::uint64_t emits = 0;
+        std::uint64_t slots = 0;
+        std::uint64_t disconnects_in_emit = 0;
+        std::uint64_t moves_in_emit = 0;
+        std::array<std::uint64_t, buckets> slot_latency{};
+
+        // lower bound of the bucket holding the q-th quantile of slot latency, q in [0, 1]
+        std::uint64_t slot_latency_quantile(double q) const noexcept
+        {
+            std::uint64_t total = 0;
+            for (auto n : slot_latency)
+                total += n;
+            if (total == 0)
+                return 0;
+            auto rank = std::uint64_t(q * double(total - 1));
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i < buckets; i++)
+            {
+                seen += slot_latency[i];
+                if (seen > rank)
+                    return bucket_lower_bound(i);
+            }
+            return bucket_lower_bound(buckets - 1);
+        }
+    };
+
+    struct emit_scope
+    {};
+    using token = std::chrono::steady_clock::time_point;
+
+    emit_scope on_emit() noexcept
+    {
+        bump(emits);
+        return {};
+    }
+    token on_slot_begin(void const*) noexcept
+    {
+        return std::chrono::steady_clock::now();
+    }
+    void on_slot_end(token begin) noexcept
+    {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+        bump(slots);
+        bump(slot_latency[bucket_of(ns < 0 ? 0 : std::uint64_t(ns))]);
+    }
+    void on_disconnect_in_emit() noexcept
+    {
+        bump(disconnects_in_emit);
+    }
+    void on_move_in_emit() noexcept
+    {
+        bump(moves_in_emit);
+    }
+
+    snapshot_type snapshot() const noexcept
+    {
+        snapshot_type s;
+        s.emits = emits.load(std::memory_order_relaxed);
+        s.slots = slots.load(std::memory_order_relaxed);
+        s.disconnects_in_emit = disconnects_in_emit.load(std::memory_order_relaxed);
+        s.moves_in_emit = moves_in_emit.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < buckets; i++)
+            s.slot_latency[i] = slot_latency[i].load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    using counter = std::atomic<std::uint64_t>;
+
+    static void bump(counter& c) noexcept
+    {
+        c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    counter emits{0};
+    counter slots{0};
+    counter disconnects_in_emit{0};
+    counter moves_in_emit{0};
+    std::array<counter, buckets> slot_latency{};
+};
+
+}
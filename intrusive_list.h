@@ -3,7 +3,9 @@
 #include <type_traits>
 #include <iterator>
 #include <cassert>
+#include <cstdint>
 #include <memory>
+#include <utility>
 
 namespace intrusive
 {
@@ -29,6 +31,11 @@ namespace intrusive
             return ret;
         }
 
+        bool linked() const noexcept
+        {
+            return next != nullptr;
+        }
+
         list_element(void) {}
 
         ~list_element()
@@ -261,7 +268,8 @@ namespace intrusive
             pos.me->prev = &v;
             return iterator(&v);
         }
-        iterator erase(const_iterator pos) noexcept
+        // needs no list, an element knows its neighbours
+        static iterator erase(const_iterator pos) noexcept
         {
             iterator ret(pos.me->next);
             pos.me->unlink();
@@ -286,4 +294,488 @@ namespace intrusive
             return iterator(&t);
         }
     };
+
+    template <typename Tag>
+    struct unrolled_element;
+
+    namespace detail
+    {
+        inline void prefetch(void const* p) noexcept
+        {
+#if defined(__GNUC__)
+            __builtin_prefetch(p);
+#else
+            (void)p;
+#endif
+        }
+
+        template <typename Tag>
+        struct unrolled_root;
+
+        // two cache lines of element pointers, empty positions are left by unlink
+        template <typename Tag>
+        struct alignas(64) unrolled_block
+        {
+            static constexpr std::uint32_t capacity = 12;
+
+            unrolled_element<Tag>* items[capacity];
+            unrolled_block* prev = nullptr;
+            unrolled_block* next = nullptr;
+            unrolled_root<Tag>* root;
+            // positions taken, empty ones included
+            std::uint32_t used = 0;
+            std::uint32_t live = 0;
+
+            explicit unrolled_block(unrolled_root<Tag>* root) noexcept
+            : root(root)
+            {}
+        };
+
+        template <typename Tag>
+        struct unrolled_root
+        {
+            using block = unrolled_block<Tag>;
+            using element = unrolled_element<Tag>;
+
+            block* first = nullptr;
+            block* last = nullptr;
+            // changes with every insert and erase, so an iterator can tell its position is still right
+            std::uint32_t version = 0;
+
+            // first element at or after position i of b, b and i are left at its position
+            static element* next_live(block*& b, std::uint32_t& i) noexcept
+            {
+                for (; b != nullptr; b = b->next, i = 0)
+                    for (; i < b->used; i++)
+                        if (b->items[i] != nullptr)
+                            return b->items[i];
+                return nullptr;
+            }
+
+            static element* find_live(block const* b, std::uint32_t i) noexcept
+            {
+                auto* from = const_cast<block*>(b);
+                return next_live(from, i);
+            }
+
+            static constexpr std::uint32_t prefetch_distance = 4;
+
+            /* while a slot runs, bring in the connection a few positions ahead, so the misses
+             * of several connections overlap. the next block is fetched as soon as iteration
+             * enters this one. only the block is read, not the element at position i */
+            static void prefetch_ahead(block const* b, std::uint32_t i) noexcept
+            {
+                auto ahead = i + prefetch_distance;
+                if (ahead < b->used)
+                {
+                    if (b->items[ahead] != nullptr)
+                        prefetch(b->items[ahead]);
+                }
+                else if (b->next != nullptr)
+                {
+                    ahead -= b->used;
+                    if (ahead < b->next->used && b->next->items[ahead] != nullptr)
+                        prefetch(b->next->items[ahead]);
+                }
+                if (i == 0 && b->next != nullptr)
+                    prefetch(b->next);
+            }
+
+            static void place(block* b, std::uint32_t i, element& e) noexcept
+            {
+                b->items[i] = &e;
+                e.owner = b;
+                e.index = i;
+            }
+
+            block* add_block(block* after)
+            {
+                auto* b = new block(this);
+                b->prev = after;
+                b->next = after == nullptr ? first : after->next;
+                (b->next == nullptr ? last : b->next->prev) = b;
+                (after == nullptr ? first : after->next) = b;
+                return b;
+            }
+
+            void drop_block(block* b) noexcept
+            {
+                (b->prev == nullptr ? first : b->prev->next) = b->next;
+                (b->next == nullptr ? last : b->next->prev) = b->prev;
+                delete b;
+            }
+
+            // squeezes out the empty positions of a block, returns where position i went
+            static std::uint32_t compact(block* b, std::uint32_t i) noexcept
+            {
+                std::uint32_t to = 0;
+                std::uint32_t moved_i = 0;
+                for (std::uint32_t from = 0; from < b->used; from++)
+                {
+                    if (from == i)
+                        moved_i = to;
+                    if (b->items[from] != nullptr)
+                        place(b, to++, *b->items[from]);
+                }
+                if (i == b->used)
+                    moved_i = to;
+                b->used = to;
+                return moved_i;
+            }
+
+            // puts e right before pos, at the back for null
+            void insert(element* pos, element& e)
+            {
+                version++;
+                block* b;
+                std::uint32_t i;
+                if (pos == nullptr)
+                {
+                    b = last;
+                    if (b == nullptr)
+                        b = add_block(nullptr);
+                    i = b->used;
+                }
+                else
+                {
+                    b = pos->owner;
+                    i = pos->index;
+                    if (i != 0 && b->items[i - 1] == nullptr)
+                    {
+                        place(b, i - 1, e);
+                        b->live++;
+                        return;
+                    }
+                }
+
+                if (b->used == block::capacity)
+                {
+                    if (b->live != block::capacity)
+                        i = compact(b, i);
+                    else
+                    {
+                        auto half = block::capacity / 2;
+                        auto* nb = add_block(b);
+                        for (auto from = half; from < block::capacity; from++)
+                            place(nb, from - half, *b->items[from]);
+                        nb->used = nb->live = block::capacity - half;
+                        b->used = b->live = half;
+                        if (i > half)
+                        {
+                            b = nb;
+                            i -= half;
+                        }
+                    }
+                }
+
+                // shift right up to the first empty position, or up to the end
+                auto hole = i;
+                while (hole < b->used && b->items[hole] != nullptr)
+                    hole++;
+                if (hole == b->used)
+                    b->used++;
+                for (auto from = hole; from > i; from--)
+                    place(b, from, *b->items[from - 1]);
+                place(b, i, e);
+                b->live++;
+            }
+
+            // returns the element that followed e
+            static element* erase(element& e) noexcept
+            {
+                auto* b = e.owner;
+                b->root->version++;
+                auto* next = find_live(b, e.index + 1);
+                b->items[e.index] = nullptr;
+                e.owner = nullptr;
+                if (--b->live == 0)
+                    b->root->drop_block(b);
+                else
+                    while (b->items[b->used - 1] == nullptr)
+                        b->used--;
+                return next;
+            }
+
+            void clear() noexcept
+            {
+                while (first != nullptr)
+                {
+                    auto* b = first;
+                    for (std::uint32_t i = 0; i < b->used; i++)
+                        if (b->items[i] != nullptr)
+                            b->items[i]->owner = nullptr;
+                    first = b->next;
+                    delete b;
+                }
+                last = nullptr;
+            }
+        };
+    }
+
+    template <typename Tag = default_tag>
+    struct unrolled_element
+    {
+    private:
+        template <typename FT, typename FTag>
+        friend class unrolled_list;
+        friend detail::unrolled_root<Tag>;
+
+        detail::unrolled_block<Tag>* owner = nullptr;
+        std::uint32_t index = 0;
+
+        void take(unrolled_element& r) noexcept
+        {
+            if (r.owner == nullptr)
+                return;
+            r.owner->root->version++;
+            detail::unrolled_root<Tag>::place(r.owner, r.index, *this);
+            r.owner = nullptr;
+        }
+    public:
+        bool linked() const noexcept
+        {
+            return owner != nullptr;
+        }
+
+        unrolled_element() = default;
+
+        ~unrolled_element()
+        {
+            if (owner != nullptr)
+                detail::unrolled_root<Tag>::erase(*this);
+        }
+
+        unrolled_element(unrolled_element&& r) noexcept
+        {
+            take(r);
+        }
+        unrolled_element& operator=(unrolled_element&& r) noexcept
+        {
+            if (owner != nullptr)
+                detail::unrolled_root<Tag>::erase(*this);
+            take(r);
+            return *this;
+        }
+    };
+
+    /* unrolled list of element pointers in blocks of two cache lines
+     * iteration reads neighbouring pointers from one block instead of chasing a pointer
+     * per element, and prefetches the element after the current one. elements still know
+     * their position, so unlink by handle and to_iterator stay O(1). an iterator is the
+     * element it points at, it stays valid until that element is unlinked.
+     * insert may allocate a block, splice moves elements one by one */
+    template <typename T, typename Tag = default_tag>
+    class unrolled_list
+    {
+    private:
+        using element = unrolled_element<Tag>;
+        using root_type = detail::unrolled_root<Tag>;
+
+        root_type root;
+
+        template<typename IT>
+        class iterator_impl
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = IT;
+            using difference_type = std::ptrdiff_t;
+            using pointer = value_type*;
+            using reference = value_type&;
+        private:
+            friend unrolled_list;
+            element* me;
+            /* where me was found, valid while the list has not changed. advancing from it
+             * does not wait for the load of me, which the caller is most likely missing on */
+            root_type* root = nullptr;
+            typename root_type::block* at = nullptr;
+            std::uint32_t pos = 0;
+            std::uint32_t version = 0;
+
+            explicit iterator_impl(element* to) noexcept
+                    : me(to)
+            {}
+            iterator_impl(element* to, root_type* root, typename root_type::block* at, std::uint32_t pos) noexcept
+                    : me(to)
+                    , root(root)
+                    , at(at)
+                    , pos(pos)
+                    , version(root->version)
+            {}
+        public:
+            iterator_impl(void) noexcept
+                    : me(nullptr)
+            {}
+            pointer operator->(void) const noexcept
+            {
+                return static_cast<IT*>(me);
+            }
+            reference operator*(void) const noexcept
+            {
+                return static_cast<IT&>(*me);
+            }
+
+            iterator_impl& operator++(void) noexcept
+            {
+                auto* b = at;
+                auto i = pos;
+                if (root == nullptr || root->version != version)
+                {
+                    b = me->owner;
+                    i = me->index;
+                }
+                i++;
+                auto* r = b->root;
+                me = root_type::next_live(b, i);
+                if (me == nullptr)
+                    return *this;
+                root_type::prefetch_ahead(b, i);
+                root = r;
+                at = b;
+                pos = i;
+                version = r->version;
+                return *this;
+            }
+            iterator_impl operator++(int) noexcept
+            {
+                auto copy = *this;
+                ++*this;
+                return copy;
+            }
+
+            template<typename T1>
+            bool operator==(const iterator_impl<T1> &r) const noexcept
+            {
+                return me == r.me;
+            }
+            template<typename T1>
+            bool operator!=(const iterator_impl<T1> &r) const noexcept
+            {
+                return !operator==(r);
+            }
+
+            operator iterator_impl<const value_type>() const noexcept
+            {
+                return iterator_impl<const value_type>(me);
+            }
+
+            bool valid() const noexcept
+            {
+                return me != nullptr;
+            }
+        };
+    public:
+        using iterator = iterator_impl<T>;
+        using const_iterator = iterator_impl<const T>;
+
+        unrolled_list() noexcept = default;
+        unrolled_list(unrolled_list const&) = delete;
+        unrolled_list(unrolled_list&& r) noexcept
+        {
+            operator=(std::move(r));
+        }
+        ~unrolled_list()
+        {
+            clear();
+        }
+
+        unrolled_list& operator=(unrolled_list const&) = delete;
+        unrolled_list& operator=(unrolled_list&& r) noexcept
+        {
+            clear();
+            root.first = std::exchange(r.root.first, nullptr);
+            root.last = std::exchange(r.root.last, nullptr);
+            for (auto* b = root.first; b != nullptr; b = b->next)
+                b->root = &root;
+            return *this;
+        }
+
+        void clear() noexcept
+        {
+            root.clear();
+        }
+
+        void push_back(T& u)
+        {
+            insert(end(), u);
+        }
+        void push_front(T& u)
+        {
+            insert(begin(), u);
+        }
+        T& front() noexcept
+        {
+            return *begin();
+        }
+
+        bool empty() const noexcept
+        {
+            return root.first == nullptr;
+        }
+
+        iterator begin() noexcept
+        {
+            auto* b = root.first;
+            std::uint32_t i = 0;
+            auto* e = root_type::next_live(b, i);
+            if (e == nullptr)
+                return end();
+            root_type::prefetch_ahead(b, i);
+            return iterator(e, &root, b, i);
+        }
+        const_iterator begin() const noexcept
+        {
+            return const_iterator(root_type::find_live(root.first, 0));
+        }
+
+        iterator end() noexcept
+        {
+            return iterator(nullptr);
+        }
+        const_iterator end() const noexcept
+        {
+            return const_iterator(nullptr);
+        }
+
+        iterator insert(const_iterator pos, T& u)
+        {
+            auto& v = static_cast<element&>(u);
+            root.insert(pos.me, v);
+            return iterator(&v);
+        }
+        static iterator erase(const_iterator pos) noexcept
+        {
+            return iterator(root_type::erase(*pos.me));
+        }
+        void splice(const_iterator pos, unrolled_list&, const_iterator first, const_iterator last)
+        {
+            while (first != last)
+            {
+                auto& e = *first.me;
+                first = const_iterator(root_type::erase(e));
+                root.insert(pos.me, e);
+            }
+        }
+        static iterator to_iterator(element& t)
+        {
+            return iterator(&t);
+        }
+    };
+
+    // element and list types of a container choice, see Policy::container of signal
+    struct linked
+    {
+        template <typename Tag>
+        using element = list_element<Tag>;
+        template <typename T, typename Tag>
+        using list = intrusive::list<T, Tag>;
+    };
+
+    struct unrolled
+    {
+        template <typename Tag>
+        using element = unrolled_element<Tag>;
+        template <typename T, typename Tag>
+        using list = unrolled_list<T, Tag>;
+    };
 }
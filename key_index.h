@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace signals
+{
+namespace detail
+{
+
+/* open addressing map from non-null pointer keys to T*, linear probing
+ * the table is allocated on the first insert and kept at most three quarters full,
+ * erase shifts the following entries back instead of leaving tombstones,
+ * so lookups never probe past the end of a run */
+template <typename T>
+class key_index
+{
+private:
+    struct entry
+    {
+        void const* key;
+        T* value;
+    };
+
+    std::unique_ptr<entry[]> table;
+    std::uint32_t mask = 0;
+    std::uint32_t count = 0;
+
+    // fibonacci hashing, the low bits of pointers are mostly alignment
+    std::uint32_t home(void const* key) const noexcept
+    {
+        auto h = std::uint64_t(reinterpret_cast<std::uintptr_t>(key)) * 0x9e3779b97f4a7c15ull;
+        return std::uint32_t(h >> 32) & mask;
+    }
+
+    std::uint32_t probe(void const* key) const noexcept
+    {
+        auto i = home(key);
+        while (table[i].key != nullptr && table[i].key != key)
+            i = (i + 1) & mask;
+        return i;
+    }
+
+    void grow()
+    {
+        auto old = std::move(table);
+        std::uint32_t old_size = old ? mask + 1 : 0;
+        std::uint32_t size = old ? old_size * 2 : 8;
+        table = std::make_unique<entry[]>(size);
+        mask = size - 1;
+        for (std::uint32_t i = 0; i < old_size; i++)
+            if (old[i].key != nullptr)
+                table[probe(old[i].key)] = old[i];
+    }
+public:
+    key_index() = default;
+    key_index(key_index const&) = delete;
+    key_index& operator=(key_index const&) = delete;
+
+    std::size_t size() const noexcept
+    {
+        return count;
+    }
+
+    T* find(void const* key) const noexcept
+    {
+        if (count == 0)
+            return nullptr;
+        return table[probe(key)].value;
+    }
+
+    // makes room for n keys, inserting up to that many does not allocate
+    void reserve(std::size_t n)
+    {
+        while (!table || n * 4 > std::size_t(mask + 1) * 3)
+            grow();
+    }
+
+    // false if key is already there, the index is unchanged then
+    bool insert(void const* key, T* value)
+    {
+        reserve(count + 1);
+        auto i = probe(key);
+        if (table[i].key != nullptr)
+            return false;
+        table[i] = {key, value};
+        count++;
+        return true;
+    }
+
+    // the value key mapped to, null if there was none
+    T* erase(void const* key) noexcept
+    {
+        if (count == 0)
+            return nullptr;
+        auto hole = probe(key);
+        auto* value = table[hole].value;
+        if (table[hole].key == nullptr)
+            return nullptr;
+        count--;
+        // move back every entry of the run that would no longer be found past the hole
+        for (auto i = (hole + 1) & mask; table[i].key != nullptr; i = (i + 1) & mask)
+        {
+            auto h = home(table[i].key);
+            if (((i - h) & mask) < ((i - hole) & mask))
+                continue;
+            table[hole] = table[i];
+            hole = i;
+        }
+        table[hole] = {nullptr, nullptr};
+        return value;
+    }
+
+    // empties the index, calling release with every value
+    template <typename F>
+    void clear(F&& release) noexcept
+    {
+        if (count == 0)
+            return;
+        for (std::uint32_t i = 0; i <= mask; i++)
+        {
+            auto* value = table[i].value;
+            if (table[i].key == nullptr)
+                continue;
+            table[i] = {nullptr, nullptr};
+            count--;
+            release(value);
+        }
+    }
+};
+
+}
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <exception>
+#include <utility>
+
+#include "combiners.h"
+#include "instrumentation.h"
+#include "intrusive_list.h"
+
+namespace signals
+{
+
+// what becomes of an exception thrown by a slot, see Policy::exception_handling
+namespace exceptions
+{
+    // leaves the emit and skips the remaining slots
+    struct propagate
+    {
+        static constexpr bool noexcept_slots = false;
+        static constexpr bool catches = false;
+    };
+
+    // connect rejects slots that may throw, so slots are called through noexcept pointers and emit is noexcept
+    struct require_noexcept
+    {
+        static constexpr bool noexcept_slots = true;
+        static constexpr bool catches = false;
+    };
+
+    // caught around every slot and handed to Sink()(std::exception_ptr), the emission goes on
+    template <typename Sink>
+    struct report
+    {
+        static_assert(noexcept(Sink()(std::exception_ptr())), "the sink must not throw");
+
+        static constexpr bool noexcept_slots = false;
+        static constexpr bool catches = true;
+
+        static void handle(std::exception_ptr e) noexcept
+        {
+            Sink()(std::move(e));
+        }
+    };
+}
+
+/* compile-time configuration of signal, to change a knob derive from it
+ * and override the member, e.g.
+ *   struct strict : signals::default_policy { static constexpr bool reject_copying_slots = true; }; */
+struct default_policy
+{
+    // connect fails to compile for slots that would copy an expensive argument, see copies_arguments_v
+    static constexpr bool reject_copying_slots = false;
+
+    // reduces the slot results of operator() for signals returning non-void
+    template <typename R>
+    using combiner = combiners::optional_last_value<R>;
+
+    /* how a signal keeps its connections, intrusive::linked or intrusive::unrolled,
+     * the latter walks faster once connections are scattered over the heap */
+    using container = intrusive::linked;
+
+    /* connections do not point back to their signal, which saves a pointer each,
+     * disconnecting one while any signal with the same policy emits on the thread walks
+     * all of their emissions instead of just its signal's */
+    static constexpr bool compact_connections = false;
+
+    /* slab connections, pooled, keyed and tracked ones, released while their signal emits
+     * only lose their slot, the signal frees them in one pass once its outermost emission
+     * is over. such a disconnect costs the same however many emissions are running.
+     * connections held by value are still unlinked right away, needs a signal that is
+     * known to its connections, so not compact ones */
+    static constexpr bool deferred_disconnect = false;
+
+    using exception_handling = exceptions::propagate;
+
+    // base of the signal receiving its emit hooks, see instrumentation.h
+    using instrumentation = no_instrumentation;
+};
+
+}
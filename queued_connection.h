@@ -0,0 +1,223 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "signals.h"
+
+namespace signals
+{
+
+namespace detail
+{
+
+/* state shared by a queued connection and the deliveries it posted
+ *
+ * arguments are copied into messages taken from a free list, the list is refilled
+ * by the executor threads when a delivery is done and grown in chunks by the
+ * emitting thread only, so a steady stream of emits does not allocate.
+ * only the emitting thread pops messages, which keeps the free list ABA free */
+template <typename Executor, typename... Args>
+struct queue_state
+{
+    using slot_type = slot<void (Args...)>;
+
+    struct message
+    {
+        message* next = nullptr;
+        std::optional<std::tuple<std::decay_t<Args>...>> args;
+    };
+
+    // what is handed to the executor, it has to run it exactly once
+    struct delivery
+    {
+        queue_state* state;
+        message* msg;
+
+        void operator()() const
+        {
+            state->deliver(msg);
+        }
+    };
+
+    static constexpr std::size_t chunk_size = 32;
+
+    Executor* executor;
+    slot_type target;
+    std::atomic<bool> alive{true};
+    std::atomic<std::size_t> refs{1};
+    std::atomic<message*> free_list{nullptr};
+    std::vector<std::unique_ptr<message[]>> chunks;
+
+    queue_state(Executor* executor, slot_type&& slot)
+    : executor(executor)
+    , target(std::move(slot))
+    {
+        grow();
+    }
+
+    void grow()
+    {
+        chunks.push_back(std::make_unique<message[]>(chunk_size));
+        auto* chunk = chunks.back().get();
+        for (std::size_t i = 0; i < chunk_size; i++)
+            push(&chunk[i]);
+    }
+
+    void push(message* m) noexcept
+    {
+        m->next = free_list.load(std::memory_order_relaxed);
+        while (!free_list.compare_exchange_weak(m->next, m, std::memory_order_release, std::memory_order_relaxed))
+            ;
+    }
+
+    message* pop() noexcept
+    {
+        auto* m = free_list.load(std::memory_order_acquire);
+        while (m != nullptr && !free_list.compare_exchange_weak(m, m->next, std::memory_order_acquire))
+            ;
+        return m;
+    }
+
+    void release() noexcept
+    {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete this;
+    }
+
+    void post(arg_ref<Args>... a)
+    {
+        auto* m = pop();
+        if (m == nullptr)
+        {
+            grow();
+            m = pop();
+        }
+        try
+        {
+            m->args.emplace(a...);
+        }
+        catch (...)
+        {
+            push(m);
+            throw;
+        }
+        refs.fetch_add(1, std::memory_order_relaxed);
+        try
+        {
+            executor->post(delivery{this, m});
+        }
+        catch (...)
+        {
+            m->args.reset();
+            push(m);
+            release();
+            throw;
+        }
+    }
+
+    void deliver(message* m)
+    {
+        struct finish
+        {
+            queue_state* state;
+            message* msg;
+            ~finish()
+            {
+                msg->args.reset();
+                state->push(msg);
+                state->release();
+            }
+        } guard{this, m};
+
+        // disconnected after the emit, the delivery is cancelled
+        if (alive.load(std::memory_order_acquire))
+            std::apply(target, *m->args);
+    }
+};
+
+}
+
+template <typename Signal, typename Executor>
+struct queued_connection;
+
+/* connection whose slot runs on an executor instead of the emitting thread
+ *
+ * Executor needs a post(F) member taking a copyable void() callable that it runs once.
+ * disconnect() cancels every delivery that has not started yet, a delivery running
+ * on another thread at that moment is not waited for */
+template <typename... Args, std::size_t InlineBytes, typename Policy, typename Executor>
+struct queued_connection<signal<void (Args...), InlineBytes, Policy>, Executor>
+{
+private:
+    using signal_type = signal<void (Args...), InlineBytes, Policy>;
+    using state_type = detail::queue_state<Executor, Args...>;
+
+    struct forwarder
+    {
+        state_type* state;
+
+        void operator()(arg_ref<Args>... a) const
+        {
+            state->post(a...);
+        }
+    };
+
+    state_type* state = nullptr;
+    typename signal_type::connection conn;
+public:
+    queued_connection() = default;
+
+    template <typename F>
+    queued_connection(signal_type& sig, Executor& executor, F&& f)
+    : state(new state_type(&executor, typename state_type::slot_type(std::forward<F>(f))))
+    , conn(sig.connect(forwarder{state}))
+    {}
+
+    ~queued_connection()
+    {
+        disconnect();
+    }
+
+    void disconnect() noexcept
+    {
+        if (state == nullptr)
+            return;
+        conn.disconnect();
+        state->alive.store(false, std::memory_order_release);
+        std::exchange(state, nullptr)->release();
+    }
+
+    queued_connection(queued_connection const&) = delete;
+    queued_connection(queued_connection&& r) noexcept
+    : state(std::exchange(r.state, nullptr))
+    , conn(std::move(r.conn))
+    {}
+
+    queued_connection& operator=(queued_connection const&) = delete;
+    queued_connection& operator=(queued_connection&& r) noexcept
+    {
+        if (this == &r)
+            return *this;
+        disconnect();
+        state = std::exchange(r.state, nullptr);
+        conn = std::move(r.conn);
+        return *this;
+    }
+};
+
+/* connects f so that every emission copies the arguments into a pooled message
+ * and posts their delivery to executor */
+template <typename Signal, typename Executor, typename F>
+queued_connection<Signal, Executor> connect_queued(Signal& sig, Executor& executor, F&& f)
+{
+    return queued_connection<Signal, Executor>(sig, executor, std::forward<F>(f));
+}
+
+}
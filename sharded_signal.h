@@ -0,0 +1,395 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "futex.h"
+#include "signals.h"
+
+/* linux only: a broadcast signal whose connections are split over shards of cpus
+ *
+ * every shard is a regular signal with a worker thread pinned to the shard's cpus.
+ * connect() puts a slot on the shard of the cpu the subscriber runs on, an emission rings
+ * the doorbell of every shard that has slots, runs the emitter's own shard itself and
+ * returns once all of them are done. each slot so runs next to the memory of the thread
+ * that connected it, instead of the emitting thread walking every connection */
+namespace signals
+{
+
+// what a sharded_signal makes a shard of
+enum class shard_by
+{
+    node,
+    core
+};
+
+namespace detail
+{
+
+// the cpus the calling thread may run on
+inline std::vector<unsigned> allowed_cpus()
+{
+    std::vector<unsigned> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+        for (unsigned c = 0; c < CPU_SETSIZE; c++)
+            if (CPU_ISSET(c, &set))
+                cpus.push_back(c);
+    if (cpus.empty())
+        cpus.push_back(0);
+    return cpus;
+}
+
+// a list like 0-3,8,10-11 as found in /sys/devices/system/node, empty if path can not be read
+inline std::vector<unsigned> read_cpulist(std::string const& path)
+{
+    std::vector<unsigned> ids;
+    std::ifstream in(path);
+    std::string list;
+    if (!std::getline(in, list))
+        return ids;
+    std::size_t pos = 0;
+    while (pos < list.size())
+    {
+        std::size_t used = 0;
+        auto first = unsigned(std::stoul(list.substr(pos), &used));
+        pos += used;
+        auto last = first;
+        if (pos < list.size() && list[pos] == '-')
+        {
+            last = unsigned(std::stoul(list.substr(pos + 1), &used));
+            pos += used + 1;
+        }
+        for (auto i = first; i <= last; i++)
+            ids.push_back(i);
+        if (pos < list.size() && list[pos] != ',')
+            break;
+        pos++;
+    }
+    return ids;
+}
+
+// the allowed cpus of every numa node having some, all of them together when that is unknown
+inline std::vector<std::vector<unsigned>> cpus_by(shard_by by)
+{
+    auto allowed = allowed_cpus();
+    std::vector<std::vector<unsigned>> groups;
+    if (by == shard_by::core)
+    {
+        for (auto c : allowed)
+            groups.push_back({c});
+        return groups;
+    }
+    for (auto node : read_cpulist("/sys/devices/system/node/online"))
+    {
+        std::vector<unsigned> cpus;
+        for (auto c : read_cpulist("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"))
+            for (auto a : allowed)
+                if (a == c)
+                    cpus.push_back(c);
+        if (!cpus.empty())
+            groups.push_back(std::move(cpus));
+    }
+    if (groups.empty())
+        groups.push_back(std::move(allowed));
+    return groups;
+}
+
+}
+
+template <typename T, std::size_t InlineBytes = default_inline_bytes, typename Policy = default_policy>
+struct sharded_signal;
+
+/* emissions are serialized and must not be made from the signal's own slots, slots must not
+ * throw. connections of a shard are locked against its emission, a slot may connect and
+ * disconnect on its own shard, connections of other shards could deadlock against their
+ * workers. connections have to be gone before the signal */
+template <typename... Args, std::size_t InlineBytes, typename Policy>
+struct sharded_signal<void (Args...), InlineBytes, Policy>
+{
+    using signal_type = signal<void (Args...), InlineBytes, Policy>;
+    struct connection;
+private:
+    using args_type = std::tuple<arg_ref<Args>...>;
+
+    // spins before a worker sleeps on its doorbell or the emitter on the workers
+    static constexpr int spins = 64;
+    static constexpr std::size_t unmapped = std::size_t(-1);
+
+    struct alignas(64) shard
+    {
+        signal_type sig;
+        std::mutex m;
+        std::size_t index;
+        std::vector<unsigned> cpus;
+        std::atomic<std::size_t> connections{0};
+        // bumped by every emission that has work for the shard
+        alignas(64) std::atomic<std::uint32_t> doorbell{0};
+        std::atomic<bool> sleeping{false};
+        std::thread worker;
+
+        shard(std::size_t index, std::vector<unsigned> cpus)
+        : index(index)
+        , cpus(std::move(cpus))
+        {}
+
+        // the shard whose slots the calling thread is running
+        static shard*& running() noexcept
+        {
+            thread_local shard* current = nullptr;
+            return current;
+        }
+
+        // its own slots run with the lock held already
+        std::unique_lock<std::mutex> lock()
+        {
+            if (running() == this)
+                return {};
+            return std::unique_lock<std::mutex>(m);
+        }
+    };
+
+    std::vector<std::unique_ptr<shard>> shards;
+    std::vector<std::size_t> shard_of_cpu;
+    std::vector<shard*> targets;
+    std::mutex emitting;
+    args_type const* current = nullptr;
+    std::atomic<bool> stopping{false};
+    alignas(64) std::atomic<std::uint32_t> remaining{0};
+    std::atomic<bool> joining{false};
+
+    void deliver(shard& s) noexcept
+    {
+        std::lock_guard<std::mutex> lock(s.m);
+        auto* prev = std::exchange(shard::running(), &s);
+        std::apply([&](auto&... a) { s.sig(a...); }, *current);
+        shard::running() = prev;
+    }
+
+    void work(shard& s) noexcept
+    {
+        if (!s.cpus.empty())
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (auto c : s.cpus)
+                CPU_SET(c, &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        }
+
+        std::uint32_t seen = 0;
+        for (;;)
+        {
+            auto bell = s.doorbell.load(std::memory_order_acquire);
+            for (int i = 0; i < spins && bell == seen; i++)
+            {
+                std::this_thread::yield();
+                bell = s.doorbell.load(std::memory_order_acquire);
+            }
+            while (bell == seen)
+            {
+                s.sleeping.store(true);
+                if (s.doorbell.load() == seen)
+                    detail::futex_wait(s.doorbell, seen);
+                s.sleeping.store(false, std::memory_order_relaxed);
+                bell = s.doorbell.load(std::memory_order_acquire);
+            }
+            seen = bell;
+            if (stopping.load(std::memory_order_acquire))
+                return;
+
+            deliver(s);
+            if (remaining.fetch_sub(1) == 1 && joining.load())
+                detail::futex_wake_all(remaining);
+        }
+    }
+
+    static void ring(shard& s) noexcept
+    {
+        s.doorbell.fetch_add(1);
+        if (s.sleeping.load())
+            detail::futex_wake_all(s.doorbell);
+    }
+
+    void join() noexcept
+    {
+        for (int i = 0; i < spins && remaining.load(std::memory_order_acquire) != 0; i++)
+            std::this_thread::yield();
+        joining.store(true);
+        for (auto left = remaining.load(); left != 0; left = remaining.load())
+            detail::futex_wait(remaining, left);
+        joining.store(false, std::memory_order_relaxed);
+    }
+public:
+    struct connection
+    {
+    private:
+        friend sharded_signal;
+
+        shard* home = nullptr;
+        typename signal_type::connection conn;
+
+        template <typename F>
+        connection(shard& s, F&& f)
+        : home(&s)
+        {
+            auto lock = s.lock();
+            conn = s.sig.connect(std::forward<F>(f));
+            s.connections.fetch_add(1, std::memory_order_relaxed);
+        }
+    public:
+        connection() = default;
+        ~connection()
+        {
+            disconnect();
+        }
+
+        connection(connection const&) = delete;
+        connection(connection&& r) noexcept
+        : home(r.home)
+        {
+            if (home == nullptr)
+                return;
+            auto lock = home->lock();
+            conn = std::move(r.conn);
+            r.home = nullptr;
+        }
+
+        connection& operator=(connection const&) = delete;
+        connection& operator=(connection&& r) noexcept
+        {
+            if (this == &r)
+                return *this;
+            disconnect();
+            if (r.home == nullptr)
+                return *this;
+            auto lock = r.home->lock();
+            conn = std::move(r.conn);
+            home = std::exchange(r.home, nullptr);
+            return *this;
+        }
+
+        void disconnect() noexcept
+        {
+            if (home == nullptr)
+                return;
+            {
+                auto lock = home->lock();
+                conn.disconnect();
+                home->connections.fetch_sub(1, std::memory_order_relaxed);
+            }
+            home = nullptr;
+        }
+
+        // the index of the shard the slot runs on
+        std::size_t shard_index() const noexcept
+        {
+            return home->index;
+        }
+    };
+
+    // a shard per numa node or per core the process may run on
+    explicit sharded_signal(shard_by by = shard_by::node)
+    : sharded_signal(detail::cpus_by(by))
+    {}
+
+    // a shard per set of cpus, the workers of empty sets are not pinned
+    explicit sharded_signal(std::vector<std::vector<unsigned>> const& cpus)
+    {
+        shards.reserve(cpus.size());
+        targets.reserve(cpus.size());
+        for (std::size_t i = 0; i < cpus.size(); i++)
+        {
+            shards.push_back(std::make_unique<shard>(i, cpus[i]));
+            for (auto c : cpus[i])
+            {
+                if (c >= shard_of_cpu.size())
+                    shard_of_cpu.resize(c + 1, unmapped);
+                if (shard_of_cpu[c] == unmapped)
+                    shard_of_cpu[c] = i;
+            }
+        }
+        for (auto& s : shards)
+            s->worker = std::thread([this, p = s.get()] { work(*p); });
+    }
+
+    sharded_signal(sharded_signal const&) = delete;
+    sharded_signal& operator=(sharded_signal const&) = delete;
+
+    ~sharded_signal()
+    {
+        std::lock_guard<std::mutex> lock(emitting);
+        stopping.store(true, std::memory_order_release);
+        for (auto& s : shards)
+        {
+            ring(*s);
+            s->worker.join();
+            assert(s->connections.load() == 0);
+        }
+    }
+
+    std::size_t shard_count() const noexcept
+    {
+        return shards.size();
+    }
+
+    // the first shard of the cpu the calling thread runs on, 0 for cpus of none
+    std::size_t local_shard() const noexcept
+    {
+        auto cpu = sched_getcpu();
+        if (cpu < 0 || std::size_t(cpu) >= shard_of_cpu.size() || shard_of_cpu[cpu] == unmapped)
+            return 0;
+        return shard_of_cpu[cpu];
+    }
+
+    // connects f on the shard of the calling thread
+    template <typename F>
+    connection connect(F&& f)
+    {
+        return connect(local_shard(), std::forward<F>(f));
+    }
+
+    template <typename F>
+    connection connect(std::size_t index, F&& f)
+    {
+        assert(index < shards.size());
+        return connection(*shards[index], std::forward<F>(f));
+    }
+
+    void operator()(arg_ref<Args>... a) noexcept
+    {
+        std::lock_guard<std::mutex> lock(emitting);
+        args_type args(a...);
+        current = &args;
+
+        auto local = local_shard();
+        targets.clear();
+        for (auto& s : shards)
+            if (s->index != local && s->connections.load(std::memory_order_relaxed) != 0)
+                targets.push_back(s.get());
+        remaining.store(std::uint32_t(targets.size()), std::memory_order_relaxed);
+        for (auto* s : targets)
+            ring(*s);
+
+        if (shards[local]->connections.load(std::memory_order_relaxed) != 0)
+            deliver(*shards[local]);
+        join();
+        current = nullptr;
+    }
+};
+
+}
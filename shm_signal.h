@@ -0,0 +1,406 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "futex.h"
+#include "signals.h"
+
+/* linux only: signals broadcast to other processes through a shared memory ring
+ *
+ * the emitting process creates a named segment holding a ring of fixed size cells, every
+ * emit copies the arguments into the next cell and publishes it with a sequence stamp,
+ * without locks and without waiting for readers. any number of processes open the segment
+ * with an shm_subscriber, each keeps its own position and reads the cells in place, a
+ * reader that falls more than a ring behind skips what was overwritten and counts it as
+ * lost. sleeping readers are woken through a futex in the segment, the emitter only makes
+ * the system call when someone sleeps. on both sides in-process slots are connected to a
+ * regular signal */
+namespace signals
+{
+
+namespace detail
+{
+
+// arguments laid out one after the other at their natural alignment
+template <typename... Ts>
+struct packed_layout
+{
+    static constexpr std::array<std::size_t, sizeof...(Ts)> offsets()
+    {
+        std::array<std::size_t, sizeof...(Ts)> r{};
+        std::size_t sizes[] = {sizeof(Ts)..., 0};
+        std::size_t aligns[] = {alignof(Ts)..., 1};
+        std::size_t at = 0;
+        for (std::size_t i = 0; i < sizeof...(Ts); i++)
+        {
+            at = (at + aligns[i] - 1) / aligns[i] * aligns[i];
+            r[i] = at;
+            at += sizes[i];
+        }
+        return r;
+    }
+
+    static constexpr std::size_t size()
+    {
+        std::size_t sizes[] = {sizeof(Ts)..., 0};
+        return sizeof...(Ts) == 0 ? 0 : offsets()[sizeof...(Ts) - 1] + sizes[sizeof...(Ts) - 1];
+    }
+
+    static constexpr std::size_t align()
+    {
+        std::size_t r = alignof(std::uint64_t);
+        for (auto a : {alignof(Ts)..., std::size_t(1)})
+            r = a > r ? a : r;
+        return r;
+    }
+};
+
+struct shm_header
+{
+    static constexpr std::uint64_t ready_magic = 0x7369676e616c7331ull;
+
+    // set last by the creator, the rest is valid once it reads ready_magic
+    std::atomic<std::uint64_t> magic;
+    std::uint64_t cell_size;
+    std::uint64_t payload_size;
+    std::uint64_t capacity;
+    // sequence of the next emission
+    alignas(64) std::atomic<std::uint64_t> head;
+    // bumped before waking, readers sleep on it
+    alignas(64) std::atomic<std::uint32_t> doorbell;
+    std::atomic<std::uint32_t> sleepers;
+};
+
+// the stamp of a cell is 2s + 1 while emission s is written into it and 2s + 2 once it is complete
+struct alignas(64) shm_cell_header
+{
+    std::atomic<std::uint64_t> stamp;
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<std::uint32_t>::is_always_lock_free,
+              "shared memory needs address free atomics");
+
+// a mapping of a named posix shared memory object
+class shm_mapping
+{
+private:
+    void* base = nullptr;
+    std::size_t length = 0;
+public:
+    shm_mapping() = default;
+
+    shm_mapping(int fd, std::size_t length)
+    : length(length)
+    {
+        base = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED)
+        {
+            int err = errno;
+            ::close(fd);
+            throw std::system_error(err, std::generic_category(), "mmap");
+        }
+        ::close(fd);
+    }
+
+    ~shm_mapping()
+    {
+        if (base != nullptr)
+            ::munmap(base, length);
+    }
+
+    shm_mapping(shm_mapping&& r) noexcept
+    : base(std::exchange(r.base, nullptr))
+    , length(std::exchange(r.length, 0))
+    {}
+    shm_mapping& operator=(shm_mapping&& r) noexcept
+    {
+        std::swap(base, r.base);
+        std::swap(length, r.length);
+        return *this;
+    }
+
+    shm_header& header() const noexcept
+    {
+        return *static_cast<shm_header*>(base);
+    }
+
+    unsigned char* cells() const noexcept
+    {
+        return static_cast<unsigned char*>(base) + sizeof(shm_header);
+    }
+};
+
+template <typename... Args>
+struct shm_format
+{
+    static_assert((std::is_trivially_copyable_v<Args> && ...), "only trivially copyable arguments can be shared");
+
+    using layout = packed_layout<Args...>;
+
+    static constexpr std::size_t payload_offset = sizeof(shm_cell_header);
+    static constexpr std::size_t cell_size = (payload_offset + layout::size() + 63) / 64 * 64;
+
+    static_assert(layout::align() <= 64, "arguments are aligned to at most a cache line");
+
+    static shm_cell_header& cell(shm_mapping const& m, std::uint64_t seq) noexcept
+    {
+        auto mask = m.header().capacity - 1;
+        return *reinterpret_cast<shm_cell_header*>(m.cells() + (seq & mask) * cell_size);
+    }
+
+    static unsigned char* payload(shm_cell_header& c) noexcept
+    {
+        return reinterpret_cast<unsigned char*>(&c) + payload_offset;
+    }
+
+    template <std::size_t... I>
+    static void store(unsigned char* to, std::index_sequence<I...>, Args const&... a) noexcept
+    {
+        constexpr auto offsets = layout::offsets();
+        (std::memcpy(to + offsets[I], &a, sizeof(Args)), ...);
+    }
+
+    template <typename F, std::size_t... I>
+    static void load(unsigned char const* from, std::index_sequence<I...>, F&& f)
+    {
+        constexpr auto offsets = layout::offsets();
+        f(*std::launder(reinterpret_cast<Args const*>(from + offsets[I]))...);
+    }
+};
+
+}
+
+template <typename T, std::size_t InlineBytes = default_inline_bytes, typename Policy = default_policy>
+struct shm_signal;
+
+template <typename T, std::size_t InlineBytes = default_inline_bytes, typename Policy = default_policy>
+struct shm_subscriber;
+
+/* emitting end, creates the segment called name, replacing a stale one, and removes it
+ * on destruction. capacity is rounded up to a power of two. like signal, it is emitted
+ * from one thread at a time */
+template <typename... Args, std::size_t InlineBytes, typename Policy>
+struct shm_signal<void (Args...), InlineBytes, Policy>
+{
+    using signal_type = signal<void (Args...), InlineBytes, Policy>;
+private:
+    using format = detail::shm_format<std::decay_t<Args>...>;
+
+    std::string name;
+    detail::shm_mapping map;
+    std::uint64_t next = 0;
+    signal_type local;
+public:
+    shm_signal(std::string segment, std::size_t capacity)
+    : name(std::move(segment))
+    {
+        std::uint64_t cap = 1;
+        while (cap < capacity)
+            cap *= 2;
+        auto length = sizeof(detail::shm_header) + cap * format::cell_size;
+
+        ::shm_unlink(name.c_str());
+        int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0)
+            throw std::system_error(errno, std::generic_category(), "shm_open " + name);
+        if (::ftruncate(fd, off_t(length)) != 0)
+        {
+            int err = errno;
+            ::close(fd);
+            ::shm_unlink(name.c_str());
+            throw std::system_error(err, std::generic_category(), "ftruncate " + name);
+        }
+        try
+        {
+            map = detail::shm_mapping(fd, length);
+        }
+        catch (...)
+        {
+            ::shm_unlink(name.c_str());
+            throw;
+        }
+
+        // the object is zero filled, so every cell starts out with stamp 0
+        auto& h = map.header();
+        h.cell_size = format::cell_size;
+        h.payload_size = format::layout::size();
+        h.capacity = cap;
+        h.magic.store(detail::shm_header::ready_magic, std::memory_order_release);
+    }
+
+    ~shm_signal()
+    {
+        ::shm_unlink(name.c_str());
+    }
+
+    shm_signal(shm_signal const&) = delete;
+    shm_signal& operator=(shm_signal const&) = delete;
+
+    // in-process slots, run after the emission is published
+    signal_type& target() noexcept
+    {
+        return local;
+    }
+
+    template <typename F>
+    typename signal_type::connection connect(F&& f)
+    {
+        return local.connect(std::forward<F>(f));
+    }
+
+    void operator()(arg_ref<Args>... a)
+    {
+        auto& h = map.header();
+        auto seq = next++;
+        auto& c = format::cell(map, seq);
+        c.stamp.store(2 * seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        format::store(format::payload(c), std::index_sequence_for<Args...>(), a...);
+        c.stamp.store(2 * seq + 2, std::memory_order_release);
+
+        // pairs with the sleeper count going up before a reader looks at head
+        h.head.store(seq + 1, std::memory_order_seq_cst);
+        if (h.sleepers.load(std::memory_order_seq_cst) != 0)
+        {
+            h.doorbell.fetch_add(1, std::memory_order_seq_cst);
+            detail::futex_wake_all(h.doorbell);
+        }
+
+        local(a...);
+    }
+};
+
+/* reading end in another process, or the same one. it starts at the emissions made after
+ * it opened the segment and delivers them to the slots of its own signal */
+template <typename... Args, std::size_t InlineBytes, typename Policy>
+struct shm_subscriber<void (Args...), InlineBytes, Policy>
+{
+    using signal_type = signal<void (Args...), InlineBytes, Policy>;
+private:
+    using format = detail::shm_format<std::decay_t<Args>...>;
+
+    detail::shm_mapping map;
+    std::uint64_t pos = 0;
+    std::uint64_t missed = 0;
+    signal_type local;
+    alignas(format::layout::align()) unsigned char scratch[format::layout::size() + 1];
+
+    // copies emission pos out of the ring, false if it is not there
+    bool read(detail::shm_cell_header& c) noexcept
+    {
+        auto stamp = c.stamp.load(std::memory_order_acquire);
+        if (stamp != 2 * pos + 2)
+            return false;
+        std::memcpy(scratch, format::payload(c), format::layout::size());
+        // an emitter lapping us rewrites the stamp before the payload
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return c.stamp.load(std::memory_order_relaxed) == stamp;
+    }
+public:
+    // throws if the segment does not exist yet or was made for other arguments
+    explicit shm_subscriber(std::string const& name)
+    {
+        int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0)
+            throw std::system_error(errno, std::generic_category(), "shm_open " + name);
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || std::size_t(st.st_size) < sizeof(detail::shm_header))
+        {
+            ::close(fd);
+            throw std::runtime_error("shm segment " + name + " is not ready");
+        }
+        map = detail::shm_mapping(fd, std::size_t(st.st_size));
+        auto& h = map.header();
+        if (h.magic.load(std::memory_order_acquire) != detail::shm_header::ready_magic)
+            throw std::runtime_error("shm segment " + name + " is not ready");
+        if (h.cell_size != format::cell_size || h.payload_size != format::layout::size()
+            || sizeof(detail::shm_header) + h.capacity * h.cell_size > std::size_t(st.st_size))
+            throw std::runtime_error("shm segment " + name + " has another layout");
+        pos = h.head.load(std::memory_order_acquire);
+    }
+
+    shm_subscriber(shm_subscriber const&) = delete;
+    shm_subscriber& operator=(shm_subscriber const&) = delete;
+
+    signal_type& target() noexcept
+    {
+        return local;
+    }
+
+    template <typename F>
+    typename signal_type::connection connect(F&& f)
+    {
+        return local.connect(std::forward<F>(f));
+    }
+
+    // emissions that were overwritten before this subscriber got to them
+    std::uint64_t lost() const noexcept
+    {
+        return missed;
+    }
+
+    // emits every published emission not yet seen, returns how many
+    std::size_t dispatch()
+    {
+        auto& h = map.header();
+        std::size_t n = 0;
+        for (;;)
+        {
+            auto head = h.head.load(std::memory_order_acquire);
+            if (pos == head)
+                return n;
+            if (head - pos > h.capacity)
+            {
+                missed += head - h.capacity - pos;
+                pos = head - h.capacity;
+            }
+            if (!read(format::cell(map, pos)))
+            {
+                // overwritten meanwhile, jump ahead to what is still in the ring
+                missed++;
+                pos++;
+                continue;
+            }
+            pos++;
+            n++;
+            format::load(scratch, std::index_sequence_for<Args...>(), local);
+        }
+    }
+
+    // sleeps until something is published or timeout passes, then dispatches
+    std::size_t wait(std::chrono::nanoseconds timeout)
+    {
+        auto& h = map.header();
+        if (auto n = dispatch())
+            return n;
+        auto bell = h.doorbell.load(std::memory_order_seq_cst);
+        h.sleepers.fetch_add(1, std::memory_order_seq_cst);
+        if (h.head.load(std::memory_order_seq_cst) == pos)
+        {
+            timespec ts{time_t(timeout.count() / 1000000000), long(timeout.count() % 1000000000)};
+            detail::futex_wait(h.doorbell, bell, &ts);
+        }
+        h.sleepers.fetch_sub(1, std::memory_order_seq_cst);
+        return dispatch();
+    }
+};
+
+}
@@ -0,0 +1,13 @@
+#include "signals.h"
+
+// the instantiations signals.h declares extern when SIGNALS_EXTERN_TEMPLATES is defined
+namespace signals
+{
+
+template class detail::signal_core<default_policy>;
+template struct signal<void ()>;
+template struct signal<void (int)>;
+template struct signal<void (bool)>;
+template struct signal<void (std::size_t)>;
+
+}
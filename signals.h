@@ -1,74 +1,387 @@
 #pragma once
-#include <functional>
+#include <cassert>
+#include <map>
+#include <tuple>
+#include <vector>
 
 #include "intrusive_list.h"
+#include "key_index.h"
+#include "policy.h"
+#include "slab_pool.h"
+#include "slot.h"
+#include "trackable.h"
 
 namespace signals
 {
 
-template <typename T>
+template <typename T, std::size_t InlineBytes = default_inline_bytes, typename Policy = default_policy>
 struct signal;
 
-template <typename... Args>
-struct signal<void (Args...)>
+// awaitables, defined in signals_coro.h
+template <typename Signal>
+struct next_awaiter;
+template <typename Signal>
+struct emit_awaiter;
+
+namespace detail
+{
+
+// the signal of a connection, compact connections do without
+template <typename Signal, bool Stored>
+struct connection_parent
+{
+    Signal* parent = nullptr;
+};
+
+template <typename Signal>
+struct connection_parent<Signal, false>
+{};
+
+// slab nodes waiting for their signal to stop emitting, see Policy::deferred_disconnect
+template <bool Deferred>
+struct parking_lot
+{
+    intrusive::list<tracking_hook, tracking_tag> parked;
+};
+
+template <>
+struct parking_lot<false>
+{};
+
+// what a slab node is parked by, nodes that are tracked already have one
+template <bool Deferred>
+struct parking_hook : tracking_hook
 {
-    struct connection;
+    parking_hook() noexcept
+    : tracking_hook(nullptr)
+    {}
+};
+
+template <>
+struct parking_hook<false>
+{};
+
+/* what a signal does that does not depend on its signature: the list, the emission
+ * frames and keeping them right through disconnects, moves and the signal's death.
+ * it is shared by every signal with the same Policy and built once by the signals
+ * library for default_policy, see the end of this file */
+template <typename Policy>
+class signal_core : protected Policy::instrumentation
+                  , private parking_lot<Policy::deferred_disconnect>
+{
+protected:
+    static constexpr bool compact = Policy::compact_connections;
+    static constexpr bool deferred = Policy::deferred_disconnect;
+
+    static_assert(!(compact && deferred), "deferred disconnects need connections that know their signal");
+public:
+    struct link;
     struct connection_list_tag;
-    struct walker_list_tag;
     struct iteration_data;
 
-    struct connection : public intrusive::list_element<connection_list_tag>
+    using list_type = typename Policy::container::template list<link, connection_list_tag>;
+
+    // the list part of a connection, the slot is added by the signal
+    struct link : public Policy::container::template element<connection_list_tag>
+                , private connection_parent<signal_core, !compact>
     {
     private:
-        using super = intrusive::list_element<connection_list_tag>;
-        friend signal;
+        using super = typename Policy::container::template element<connection_list_tag>;
+        friend signal_core;
 
-        signal* parent;
-        intrusive::list<iteration_data, walker_list_tag> lst;
-        std::function<void (Args...)> slot; // noexcept constructible since 2020
+        // emissions that may be on this connection, innermost first
+        iteration_data* running() const noexcept
+        {
+            if constexpr (compact)
+                return thread_frames();
+            else
+                return this->parent->emissions;
+        }
+    protected:
+        link() = default;
 
-        connection(signal* parent, std::function<void (Args...)>&& slot) noexcept
-        : parent(parent)
-        , slot(std::move(slot))
+        link(signal_core* sig) noexcept(noexcept(sig->lst.push_front(std::declval<link&>())))
         {
-            parent->lst.push_front(*this);
+            if constexpr (!compact)
+                this->parent = sig;
+            sig->lst.push_front(*this);
         }
 
-        void movelinks(connection& r) noexcept
+        link(signal_core* sig, typename list_type::const_iterator pos)
         {
-            super::operator=(std::move(static_cast<super&>(r)));
-            lst = std::move(r.lst);
-            for (auto& a : lst)
-                a.held = intrusive::list<connection, connection_list_tag>::to_iterator(*this);
+            if constexpr (!compact)
+                this->parent = sig;
+            sig->lst.insert(pos, *this);
         }
+
+        ~link() = default;
+
+        void movelinks(link& r) noexcept;
     public:
-        connection() = default;
-        ~connection()
+        void disconnect() noexcept;
+    };
+
+    /* one per running emission, linked into the signal rather than into the connections,
+     * so invoking a slot costs two local stores. disconnect and move only walk these
+     * when the signal is emitting. with compact connections the frames are linked per
+     * thread instead, a connection finds them without knowing its signal */
+    struct iteration_data
+    {
+        signal_core* sig;
+        iteration_data* prev;
+        // connection being invoked; after a disconnect, the one to invoke next
+        typename list_type::iterator held;
+        bool deleted = false;
+        bool stopped = false;
+
+        explicit iteration_data(signal_core* sig) noexcept
+        : sig(sig)
+        , prev(head(sig))
         {
-            disconnect();
+            head(sig) = this;
         }
-
-        void disconnect() noexcept
+        ~iteration_data()
         {
-            auto next = super::unlink();
-            typename intrusive::list<connection, connection_list_tag>::iterator asit;
-            if (next != nullptr)
-                asit = intrusive::list<connection, connection_list_tag>::to_iterator(*next);
-            for (auto& a : lst)
+            if constexpr (compact)
+                thread_frames() = prev;
+            else if (sig != nullptr)
             {
-                a.deleted = true;
-                a.held = asit;
+                sig->emissions = prev;
+                if constexpr (deferred)
+                    if (prev == nullptr)
+                        sig->sweep();
             }
-            if (asit.valid() && asit != parent->lst.end())
-                asit->lst.splice(asit->lst.begin(), lst, lst.begin(), lst.end());
+        }
+
+        static iteration_data*& head(signal_core* sig) noexcept
+        {
+            if constexpr (compact)
+                return thread_frames();
             else
-                lst.clear();
+                return sig->emissions;
+        }
+
+        iteration_data(iteration_data const&) = delete;
+        iteration_data& operator=(iteration_data const&) = delete;
+    };
+
+    list_type lst;
+
+    // called from a slot, skips the rest of the slots of the innermost running emission
+    void stop_emission() noexcept;
+
+    // emissions return right away until unblock_all(), running ones go on
+    void block_all() noexcept
+    {
+        blocking_all = true;
+    }
+
+    void unblock_all() noexcept
+    {
+        blocking_all = false;
+    }
+
+    bool all_blocked() const noexcept
+    {
+        return blocking_all;
+    }
+protected:
+    signal_core() = default;
+    ~signal_core()
+    {
+        if constexpr (deferred)
+            sweep();
+        detach_emissions();
+    }
+
+    signal_core(signal_core const&) = delete;
+    signal_core& operator=(signal_core const&) = delete;
+
+    /* disconnects c, or just unlinks it when its signal is idle, which idle remembers
+     * across calls with nothing run in between. returns what idle is next */
+    static signal_core* disconnect_batched(link& c, signal_core* idle) noexcept;
+
+    /* with deferred disconnects, parks the slab node owning c if its signal is emitting.
+     * c stays in the list and free(&hook) is called once the outermost emission is over,
+     * returns false if the node can be freed right away */
+    static bool park(link& c, tracking_hook& hook, void (*free)(tracking_hook*) noexcept) noexcept
+    {
+        if constexpr (deferred)
+        {
+            if (!c.linked() || c.parent->emissions == nullptr)
+                return false;
+            hook.release = free;
+            c.parent->parked.push_back(hook);
+            return true;
+        }
+        else
+            return false;
+    }
+    bool blocking_all = false;
+private:
+    iteration_data* emissions = nullptr;
+
+    // running emissions of every compact signal of this policy on the calling thread
+    static iteration_data*& thread_frames() noexcept
+    {
+        thread_local iteration_data* frames = nullptr;
+        return frames;
+    }
+
+    // lets running emissions know they have nothing left to walk
+    void detach_emissions() noexcept;
+
+    // frees what was parked, nothing is walking the list any more
+    void sweep() noexcept
+    {
+        if constexpr (deferred)
+        {
+            while (!this->parked.empty())
+            {
+                auto& hook = this->parked.front();
+                this->parked.pop_front();
+                hook.release(&hook);
+            }
+        }
+    }
+};
+
+template <typename Policy>
+void signal_core<Policy>::link::movelinks(link& r) noexcept
+{
+    bool linked = r.linked();
+    super::operator=(std::move(static_cast<super&>(r)));
+    if constexpr (!compact)
+        this->parent = r.parent;
+    if (!linked)
+        return;
+    for (auto* d = running(); d != nullptr; d = d->prev)
+    {
+        if (d->held != list_type::to_iterator(r) || d->sig == nullptr)
+            continue;
+        d->held = list_type::to_iterator(*this);
+        d->sig->on_move_in_emit();
+    }
+}
+
+template <typename Policy>
+void signal_core<Policy>::link::disconnect() noexcept
+{
+    // not linked when disconnected or when the signal is gone
+    if (!super::linked())
+        return;
+    auto self = list_type::to_iterator(*this);
+    auto next = list_type::erase(self);
+    for (auto* d = running(); d != nullptr; d = d->prev)
+    {
+        if (d->held != self || d->sig == nullptr)
+            continue;
+        d->held = next;
+        d->deleted = true;
+        d->sig->on_disconnect_in_emit();
+    }
+}
+
+template <typename Policy>
+void signal_core<Policy>::stop_emission() noexcept
+{
+    if constexpr (compact)
+    {
+        for (auto* d = thread_frames(); d != nullptr; d = d->prev)
+        {
+            if (d->sig != this)
+                continue;
+            d->stopped = true;
+            return;
+        }
+    }
+    else if (emissions != nullptr)
+        emissions->stopped = true;
+}
+
+template <typename Policy>
+signal_core<Policy>* signal_core<Policy>::disconnect_batched(link& c, signal_core* idle) noexcept
+{
+    if (!c.linked())
+        return idle;
+    if constexpr (compact)
+        c.disconnect();
+    else
+    {
+        if (c.parent == idle)
+        {
+            list_type::erase(list_type::to_iterator(c));
+            return idle;
+        }
+        idle = c.parent->emissions == nullptr ? c.parent : nullptr;
+        c.disconnect();
+    }
+    return idle;
+}
+
+template <typename Policy>
+void signal_core<Policy>::detach_emissions() noexcept
+{
+    if constexpr (compact)
+    {
+        for (auto* d = thread_frames(); d != nullptr; d = d->prev)
+            if (d->sig == this)
+                d->sig = nullptr;
+    }
+    else
+    {
+        for (auto* d = emissions; d != nullptr; d = d->prev)
+            d->sig = nullptr;
+        emissions = nullptr;
+    }
+}
+
+}
+
+template <typename R, typename... Args, std::size_t InlineBytes, typename Policy>
+struct signal<R (Args...), InlineBytes, Policy> : public detail::signal_core<Policy>
+{
+private:
+    using core = detail::signal_core<Policy>;
+    using core::compact;
+    using core::deferred;
+
+    using exception_handling = typename Policy::exception_handling;
+    // with noexcept slots or with every slot call wrapped, nothing can escape an emission of a void signal
+    static constexpr bool nothrow_emit = exception_handling::noexcept_slots || exception_handling::catches;
+public:
+    using slot_type = slot<R (Args...) noexcept(exception_handling::noexcept_slots), InlineBytes>;
+    using typename core::list_type;
+    using typename core::iteration_data;
+    using core::lst;
+
+    struct connection : public core::link
+    {
+    private:
+        friend signal;
+
+        slot_type slot;
+
+        connection(signal* sig, slot_type&& slot) noexcept(std::is_nothrow_constructible_v<typename core::link, core*>)
+        : core::link(sig)
+        , slot(std::move(slot))
+        {}
+
+        connection(signal* sig, slot_type&& slot, typename list_type::const_iterator pos)
+        : core::link(sig, pos)
+        , slot(std::move(slot))
+        {}
+    public:
+        connection() = default;
+        ~connection()
+        {
+            this->disconnect();
         }
 
         connection(connection const&) = delete;
         connection(connection&& r) noexcept : slot(std::move(r.slot))
         {
-            movelinks(r);
+            this->movelinks(r);
         }
 
         connection& operator=(connection const&) = delete;
@@ -76,56 +389,580 @@ struct signal<void (Args...)>
         {
             if (this == &r)
                 return *this;
-            movelinks(r);
+            this->disconnect();
+            this->movelinks(r);
             slot = std::move(r.slot);
             return *this;
         }
+
+        /* emissions pass over a blocked connection as over an empty one, it keeps its
+         * place and its slot and moves along with the connection */
+        void block() noexcept
+        {
+            slot.block();
+        }
+
+        void unblock() noexcept
+        {
+            slot.unblock();
+        }
+
+        bool blocked() const noexcept
+        {
+            return slot.blocked();
+        }
     };
 
-    struct iteration_data : public intrusive::list_element<walker_list_tag>
+    // the list links, the signal unless compact and the slot, nothing else
+    static_assert(sizeof(connection) == sizeof(typename Policy::container::template element<typename core::connection_list_tag>)
+                                        + (compact ? 0 : sizeof(void*)) + sizeof(slot_type),
+                  "connection is not packed");
+
+    struct pooled_connection;
+
+private:
+    struct pooled_node;
+    struct tracked_node;
+
+    // shared by the signal and every live node, so handles may outlive the signal
+    struct connection_pool
     {
-        typename intrusive::list<connection, connection_list_tag>::iterator held;
-        bool deleted = false;
-        explicit iteration_data(decltype(held) held) : held(held)
+        detail::slab_pool<pooled_node> slab;
+        detail::slab_pool<tracked_node> tracked;
+        std::size_t refs = 1;
+
+        void release() noexcept
+        {
+            if (--refs == 0)
+                delete this;
+        }
+    };
+
+    // empties the slot of a node released while its signal emits and parks the node
+    template <typename Node>
+    static bool park(Node* node, void (*free)(detail::tracking_hook*) noexcept) noexcept
+    {
+        if (!core::park(node->conn, *node, free))
+            return false;
+        node->conn.slot.reset();
+        return true;
+    }
+
+    struct pooled_node : detail::parking_hook<Policy::deferred_disconnect>
+    {
+        connection conn;
+        connection_pool* pool;
+
+        static void release(pooled_node* node) noexcept
+        {
+            if constexpr (deferred)
+                if (park(node, &free))
+                    return;
+            destroy(node);
+        }
+
+        static void free(detail::tracking_hook* hook) noexcept
+        {
+            if constexpr (deferred)
+                destroy(static_cast<pooled_node*>(hook));
+        }
+
+        static void destroy(pooled_node* node) noexcept
+        {
+            auto* p = node->pool;
+            node->~pooled_node();
+            p->slab.deallocate(node);
+            p->release();
+        }
+    };
+
+    // owned by the tracked object, freed when it goes away
+    struct tracked_node : detail::tracking_hook
+    {
+        connection conn;
+        connection_pool* pool;
+
+        tracked_node(connection&& conn, connection_pool* pool) noexcept
+        : detail::tracking_hook(&release)
+        , conn(std::move(conn))
+        , pool(pool)
+        {}
+
+        static void release(detail::tracking_hook* hook) noexcept
+        {
+            if constexpr (deferred)
+                if (park(static_cast<tracked_node*>(hook), &destroy))
+                    return;
+            destroy(hook);
+        }
+
+        static void destroy(detail::tracking_hook* hook) noexcept
+        {
+            auto* node = static_cast<tracked_node*>(hook);
+            auto* p = node->pool;
+            node->~tracked_node();
+            p->tracked.deallocate(node);
+            p->release();
+        }
+    };
+
+    connection_pool& shared_pool()
+    {
+        if (pool == nullptr)
+            pool = new connection_pool();
+        return *pool;
+    }
+
+    connection_pool* pool = nullptr;
+public:
+    /* handle to a connection stored in the signal's slab,
+     * moves are pointer copies no matter how many emissions are walking the node */
+    struct pooled_connection
+    {
+    private:
+        friend signal;
+        pooled_node* node = nullptr;
+
+        explicit pooled_connection(pooled_node* node) noexcept
+        : node(node)
+        {}
+    public:
+        pooled_connection() = default;
+        ~pooled_connection()
+        {
+            disconnect();
+        }
+
+        void disconnect() noexcept
+        {
+            if (node == nullptr)
+                return;
+            pooled_node::release(node);
+            node = nullptr;
+        }
+
+        void block() noexcept
+        {
+            if (node != nullptr)
+                node->conn.block();
+        }
+
+        void unblock() noexcept
+        {
+            if (node != nullptr)
+                node->conn.unblock();
+        }
+
+        bool blocked() const noexcept
+        {
+            return node != nullptr && node->conn.blocked();
+        }
+
+        pooled_connection(pooled_connection const&) = delete;
+        pooled_connection(pooled_connection&& r) noexcept
+        : node(r.node)
         {
-            held->lst.push_front(*this);
+            r.node = nullptr;
+        }
+
+        pooled_connection& operator=(pooled_connection const&) = delete;
+        pooled_connection& operator=(pooled_connection&& r) noexcept
+        {
+            if (this == &r)
+                return *this;
+            disconnect();
+            node = r.node;
+            r.node = nullptr;
+            return *this;
         }
     };
 
-    intrusive::list<connection, connection_list_tag> lst;
+    /* connections kept side by side and torn down together, possibly to several signals.
+     * disconnect() unlinks them in one pass over the storage and looks at the emission
+     * state of a signal once per run of its connections instead of once per connection */
+    struct connection_group
+    {
+    private:
+        std::vector<connection> conns;
+    public:
+        connection_group() = default;
+        ~connection_group()
+        {
+            disconnect();
+        }
+
+        connection_group(connection_group const&) = delete;
+        connection_group(connection_group&&) noexcept = default;
+        connection_group& operator=(connection_group const&) = delete;
+        connection_group& operator=(connection_group&& r) noexcept
+        {
+            if (this == &r)
+                return *this;
+            disconnect();
+            conns = std::move(r.conns);
+            return *this;
+        }
+
+        template <typename F>
+        void connect(signal& sig, F&& f)
+        {
+            conns.push_back(sig.connect(std::forward<F>(f)));
+        }
+
+        void add(connection&& c)
+        {
+            conns.push_back(std::move(c));
+        }
+
+        void reserve(std::size_t count)
+        {
+            conns.reserve(count);
+        }
+
+        std::size_t size() const noexcept
+        {
+            return conns.size();
+        }
+
+        void disconnect() noexcept
+        {
+            // nothing runs a slot in between, so a signal found idle stays idle
+            core* idle = nullptr;
+            for (auto& c : conns)
+                idle = core::disconnect_batched(c, idle);
+            conns.clear();
+        }
+    };
 
     signal() = default;
+    ~signal()
+    {
+        keyed.clear(&pooled_node::release);
+        if (pool != nullptr)
+            pool->release();
+    }
 
     signal(signal const&) = delete;
     signal(signal&&) = delete;
     signal& operator=(signal const&) = delete;
     signal& operator=(signal&&) = delete;
 
-    connection connect(std::function<void (Args...)> slot) noexcept
+private:
+    // connections made with a key, kept in the slab
+    detail::key_index<pooled_node> keyed;
+    // each group is delimited by a sentinel connection with an empty slot
+    std::map<int, connection> groups;
+
+    typename list_type::iterator group_begin(int group)
+    {
+        auto it = groups.lower_bound(group);
+        if (it == groups.end() || it->first != group)
+        {
+            auto pos = it == groups.end() ? lst.end() : list_type::to_iterator(it->second);
+            it = groups.emplace_hint(it, group, connection(this, slot_type(), pos));
+        }
+        return std::next(list_type::to_iterator(it->second));
+    }
+
+    /* stops at the next live connection, which the walk goes on with anyway. over an
+     * emission it so reads each connection at most once more, trailing blocked ones included */
+    bool is_last(typename list_type::iterator it)
     {
-        auto ret = connection(this, std::move(slot));
+        for (++it; it != lst.end(); ++it)
+            if (at(it).slot)
+                return false;
+        return true;
+    }
 
-        return ret;
+    static connection& at(typename list_type::iterator it) noexcept
+    {
+        return static_cast<connection&>(*it);
     }
 
-    void operator()(Args... a)
+    template <typename F>
+    static slot_type make_slot(F&& f) noexcept(std::is_nothrow_constructible_v<slot_type, F&&>)
     {
+        static_assert(!Policy::reject_copying_slots || !copies_arguments_v<F>,
+                      "slot takes an expensive argument by value, take it by const reference");
+        static_assert(!exception_handling::noexcept_slots || std::is_nothrow_invocable_v<std::decay_t<F>&, arg_ref<Args>...>,
+                      "slot may throw, the policy asks for noexcept slots");
+        return slot_type(std::forward<F>(f));
+    }
+
+    static void call_lone(slot_type& slot, arg_ref<Args>... a) noexcept(nothrow_emit)
+    {
+        if constexpr (exception_handling::catches)
+        {
+            try
+            {
+                slot(a...);
+            }
+            catch (...)
+            {
+                exception_handling::handle(std::current_exception());
+            }
+        }
+        else
+            slot(a...);
+    }
+
+    // calls visit(d) for every connection in order, d.held is the one to invoke
+    template <typename Visit>
+    void walk(Visit&& visit)
+    {
+        if (this->blocking_all)
+            return;
+        [[maybe_unused]] auto scope = this->on_emit();
         if (lst.empty())
             return;
+        iteration_data d(this);
         auto cur = lst.begin();
 
-        while (cur.valid() && cur != lst.end())
+        while (cur != lst.end())
         {
-            iteration_data d(cur);
+            if (!at(cur).slot)
+            {
+                ++cur;
+                continue;
+            }
+            d.held = cur;
+            d.deleted = false;
 
-            cur->slot(a...);
+            auto token = this->on_slot_begin(&at(cur));
+            if constexpr (exception_handling::catches)
+            {
+                try
+                {
+                    visit(d);
+                }
+                catch (...)
+                {
+                    exception_handling::handle(std::current_exception());
+                }
+            }
+            else
+                visit(d);
 
+            if (d.sig == nullptr)
+                return;
+            this->on_slot_end(token);
+            if (d.stopped)
+                return;
+            cur = d.held;
             if (!d.deleted)
                 ++cur;
-            else
-                cur = d.held;
         }
     }
+public:
+    template <typename F>
+    connection connect(F&& f) noexcept(std::is_nothrow_constructible_v<slot_type, F&&>
+                                       && noexcept(lst.push_front(std::declval<connection&>())))
+    {
+        auto ret = connection(this, make_slot(std::forward<F>(f)));
+
+        return ret;
+    }
+
+    /* slots of lower groups run first, all of them after the ungrouped ones,
+     * inside a group newer slots run first as well */
+    template <typename F>
+    connection connect(int group, F&& f)
+    {
+        auto pos = group_begin(group);
+        return connection(this, make_slot(std::forward<F>(f)), pos);
+    }
+
+    typename Policy::instrumentation& instrumentation() noexcept
+    {
+        return *this;
+    }
+
+    template <typename F>
+    pooled_connection connect_pooled(F&& f)
+    {
+        auto& p = shared_pool();
+        auto* node = ::new (p.slab.allocate()) pooled_node{{}, connection(this, make_slot(std::forward<F>(f))), &p};
+        ++p.refs;
+        return pooled_connection(node);
+    }
+
+    /* connects f under key unless a slot is already connected under it, returns whether it was
+     * the slot lives until disconnect(key) or until the signal dies */
+    template <typename F>
+    bool connect(void const* key, F&& f)
+    {
+        assert(key != nullptr);
+        if (keyed.find(key) != nullptr)
+            return false;
+        keyed.reserve(keyed.size() + 1);
+        auto& p = shared_pool();
+        auto* node = ::new (p.slab.allocate()) pooled_node{{}, connection(this, make_slot(std::forward<F>(f))), &p};
+        ++p.refs;
+        keyed.insert(key, node);
+        return true;
+    }
+
+    bool connected(void const* key) const noexcept
+    {
+        return keyed.find(key) != nullptr;
+    }
+
+    // disconnects the slot connected under key, may be called from any slot, returns whether there was one
+    bool disconnect(void const* key) noexcept
+    {
+        auto* node = keyed.erase(key);
+        if (node == nullptr)
+            return false;
+        pooled_node::release(node);
+        return true;
+    }
+
+    /* connects f for as long as both obj and the signal live, the connection is kept
+     * in the signal's slab and disconnected by obj's destructor, even in the middle of
+     * an emission. the slot itself pays nothing for the tracking */
+    template <typename F>
+    void connect_tracked(trackable& obj, F&& f)
+    {
+        auto& p = shared_pool();
+        auto* node = ::new (p.tracked.allocate()) tracked_node(connection(this, make_slot(std::forward<F>(f))), &p);
+        ++p.refs;
+        obj.track(*node);
+    }
+
+    // for non-void signals the results are reduced by Policy::combiner
+    decltype(auto) operator()(arg_ref<Args>... a) noexcept(nothrow_emit && std::is_void_v<R>)
+    {
+        if constexpr (std::is_void_v<R>)
+        {
+            if constexpr (std::is_same_v<typename Policy::instrumentation, no_instrumentation>)
+            {
+                /* a lone slot is called without an emission frame, nothing is left to walk
+                 * after it, so its signal is not touched again. slots it connects into a
+                 * group therefore first run in the next emission */
+                auto first = lst.begin();
+                if (this->blocking_all)
+                    return;
+                if (first != lst.end() && std::next(first) == lst.end() && at(first).slot)
+                {
+                    call_lone(at(first).slot, a...);
+                    return;
+                }
+            }
+            walk([&](iteration_data& d)
+            {
+                at(d.held).slot(a...);
+            });
+        }
+        else
+            return combine(typename Policy::template combiner<R>(), a...);
+    }
+
+    /* feeds the result of every slot to the combiner and returns its result(),
+     * the emission stops as soon as the combiner returns false */
+    template <typename Combiner>
+    decltype(auto) combine(Combiner&& c, arg_ref<Args>... a)
+    {
+        static_assert(!std::is_void_v<R>, "slots of a void signal have no results to combine");
+        walk([&](iteration_data& d)
+        {
+            if (!c(at(d.held).slot(a...)))
+                d.stopped = true;
+        });
+        return c.result();
+    }
+
+    /* same as operator(), except that the last slot is given the arguments as rvalues,
+     * so a slot at the end of the list taking them by value gets them moved in */
+    void emit_move(Args&&... a) noexcept(nothrow_emit)
+    {
+        walk([&](iteration_data& d)
+        {
+            if (is_last(d.held))
+                at(d.held).slot.consume(std::forward<Args>(a)...);
+            else
+                at(d.held).slot(a...);
+        });
+    }
+
+    // co_await sig.next() suspends until the next emission, needs signals_coro.h
+    template <typename Self = signal>
+    next_awaiter<Self> next() noexcept
+    {
+        return next_awaiter<Self>(*this);
+    }
+
+    /* for signal<task(Args...)>, co_await sig.emit_async(args...) finishes
+     * once every coroutine slot has, needs signals_coro.h */
+    template <typename Self = signal>
+    emit_awaiter<Self> emit_async(arg_ref<Args>... a) noexcept
+    {
+        return emit_awaiter<Self>(*this, a...);
+    }
+
+    /* delivers every tuple of the batch to a slot before moving to the next one,
+     * a slot disconnected in the middle of the batch misses the rest of it */
+    template <typename Range>
+    void emit_batch(Range const& batch) noexcept(nothrow_emit)
+    {
+        walk([&](iteration_data& d)
+        {
+            for (auto const& args : batch)
+            {
+                std::apply(at(d.held).slot, args);
+                if (d.deleted || d.sig == nullptr || !at(d.held).slot)
+                    break;
+            }
+        });
+    }
+};
+
+/* blocks a connection or a pooled_connection for as long as it lives, one that was blocked
+ * already stays blocked. blocks of the same connection have to end in the reverse order they
+ * were made in, and the connection must not be moved away from while blocked */
+template <typename Connection>
+class shared_connection_block
+{
+private:
+    Connection* conn;
+    bool blocked;
+public:
+    explicit shared_connection_block(Connection& c) noexcept
+    : conn(&c)
+    , blocked(!c.blocked())
+    {
+        c.block();
+    }
+
+    ~shared_connection_block()
+    {
+        unblock();
+    }
+
+    shared_connection_block(shared_connection_block const&) = delete;
+    shared_connection_block& operator=(shared_connection_block const&) = delete;
+
+    // ends the block early
+    void unblock() noexcept
+    {
+        if (blocked)
+            conn->unblock();
+        blocked = false;
+    }
 };
 
 }
+
+/* built once by the signals library, which defines SIGNALS_EXTERN_TEMPLATES for
+ * everything linking it, so those translation units do not instantiate them again */
+#if defined(SIGNALS_EXTERN_TEMPLATES)
+namespace signals
+{
+
+extern template class detail::signal_core<default_policy>;
+extern template struct signal<void ()>;
+extern template struct signal<void (int)>;
+extern template struct signal<void (bool)>;
+extern template struct signal<void (std::size_t)>;
+
+}
+#endif
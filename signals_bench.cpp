@@ -0,0 +1,523 @@
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include "signals.h"
+#include "coalescing_signal.h"
+#include "dense_signal.h"
+#include "static_signal.h"
+#if defined(__linux__)
+#include <unistd.h>
+#include "sharded_signal.h"
+#include "shm_signal.h"
+#endif
+
+namespace
+{
+    using signal_t = signals::signal<void()>;
+    using connection = signal_t::connection;
+
+    std::vector<connection> connect_counters(signal_t& sig, std::size_t count, std::uint64_t& counter)
+    {
+        std::vector<connection> conns;
+        conns.reserve(count);
+        for (std::size_t i = 0; i < count; i++)
+            conns.push_back(sig.connect([&counter] { ++counter; }));
+        return conns;
+    }
+}
+
+static void emit(benchmark::State& state)
+{
+    signal_t sig;
+    std::uint64_t counter = 0;
+    auto conns = connect_counters(sig, state.range(0), counter);
+
+    for (auto _ : state)
+        sig();
+
+    benchmark::DoNotOptimize(counter);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(emit)->Arg(0)->Arg(1)->Arg(16)->Arg(1024);
+
+// what emit/1 compares with
+static void call_std_function(benchmark::State& state)
+{
+    std::uint64_t counter = 0;
+    std::function<void()> f = [&counter] { ++counter; };
+    benchmark::DoNotOptimize(f);
+
+    for (auto _ : state)
+    {
+        f();
+        benchmark::ClobberMemory();
+    }
+
+    benchmark::DoNotOptimize(counter);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(call_std_function);
+
+namespace
+{
+    struct unrolled_policy : signals::default_policy
+    {
+        using container = intrusive::unrolled;
+    };
+}
+
+// connections visited in an order unrelated to where they live in memory
+template <typename Signal>
+static void emit_scattered(benchmark::State& state)
+{
+    Signal sig;
+    std::uint64_t counter = 0;
+    std::vector<std::unique_ptr<typename Signal::connection>> conns;
+    std::vector<std::unique_ptr<char[]>> padding;
+    for (std::int64_t i = 0; i < state.range(0); i++)
+    {
+        conns.push_back(std::make_unique<typename Signal::connection>());
+        padding.push_back(std::make_unique<char[]>(192));
+    }
+    std::vector<std::size_t> order(conns.size());
+    for (std::size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::shuffle(order.begin(), order.end(), std::mt19937(42));
+    for (auto i : order)
+        *conns[i] = sig.connect([&counter] { ++counter; });
+
+    for (auto _ : state)
+        sig();
+
+    benchmark::DoNotOptimize(counter);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(emit_scattered, signal_t)->Arg(16)->Arg(1024)->Arg(65536);
+BENCHMARK_TEMPLATE(emit_scattered, signals::signal<void(), signals::default_inline_bytes, unrolled_policy>)->Arg(16)->Arg(1024)->Arg(65536);
+
+static void emit_dense(benchmark::State& state)
+{
+    signals::dense_signal<void()> sig;
+    std::uint64_t counter = 0;
+    std::vector<signals::dense_signal<void()>::connection> conns;
+    for (std::int64_t i = 0; i < state.range(0); i++)
+        conns.push_back(sig.connect([&counter] { ++counter; }));
+
+    for (auto _ : state)
+        sig();
+
+    benchmark::DoNotOptimize(counter);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(emit_dense)->Arg(0)->Arg(1)->Arg(16)->Arg(1024);
+
+static void emit_static(benchmark::State& state)
+{
+    std::uint64_t counter = 0;
+    auto sig = signals::make_static_signal<void (int)>(
+            [&counter](int v) { counter += v; },
+            [&counter](int v) { counter ^= v; },
+            [&counter](int v) { counter += 2 * v; },
+            [&counter](int v) { counter -= v; });
+
+    for (auto _ : state)
+        for (int i = 0; i < 1024; i++)
+            sig(i);
+
+    benchmark::DoNotOptimize(counter);
+    state.SetItemsProcessed(state.iterations() * sig.size * 1024);
+}
+BENCHMARK(emit_static);
+
+static void emit_static_dynamic(benchmark::State& state)
+{
+    signals::signal<void (int)> sig;
+    std::uint64_t counter = 0;
+    auto c1 = sig.connect([&counter](int v) { counter -= v; });
+    auto c2 = sig.connect([&counter](int v) { counter += 2 * v; });
+    auto c3 = sig.connect([&counter](int v) { counter ^= v; });
+    auto c4 = sig.connect([&counter](int v) { counter += v; });
+
+    for (auto _ : state)
+        for (int i = 0; i < 1024; i++)
+            sig(i);
+
+    benchmark::DoNotOptimize(counter);
+    state.SetItemsProcessed(state.iterations() * 4 * 1024);
+}
+BENCHMARK(emit_static_dynamic);
+
+static void emit_loop(benchmark::State& state)
+{
+    signals::signal<void (int)> sig;
+    std::uint64_t counter = 0;
+    std::vector<signals::signal<void (int)>::connection> conns;
+    for (std::int64_t i = 0; i < state.range(0); i++)
+        conns.push_back(sig.connect([&counter](int v) { counter += v; }));
+
+    for (auto _ : state)
+        for (int i = 0; i < 1024; i++)
+            sig(i);
+
+    benchmark::DoNotOptimize(counter);
+    state.SetItemsProcessed(state.iterations() * state.range(0) * 1024);
+}
+BENCHMARK(emit_loop)->Arg(1)->Arg(16);
+
+static void emit_batch(benchmark::State& state)
+{
+    signals::signal<void (int)> sig;
+    std::uint64_t counter = 0;
+    std::vector<signals::signal<void (int)>::connection> conns;
+    for (std::int64_t i = 0; i < state.range(0); i++)
+        conns.push_back(sig.connect([&counter](int v) { counter += v; }));
+    std::vector<std::tuple<int>> batch;
+    for (int i = 0; i < 1024; i++)
+        batch.emplace_back(i);
+
+    for (auto _ : state)
+        sig.emit_batch(batch);
+
+    benchmark::DoNotOptimize(counter);
+    state.SetItemsProcessed(state.iterations() * state.range(0) * 1024);
+}
+BENCHMARK(emit_batch)->Arg(1)->Arg(16);
+
+static void connect_disconnect(benchmark::State& state)
+{
+    signal_t sig;
+    std::uint64_t counter = 0;
+    auto conns = connect_counters(sig, state.range(0), counter);
+
+    for (auto _ : state)
+    {
+        auto conn = sig.connect([&counter] { ++counter; });
+        benchmark::DoNotOptimize(conn);
+    }
+}
+BENCHMARK(connect_disconnect)->Arg(0)->Arg(1024);
+
+/* the last live slot gets the argument moved in, with as many blocked slots behind the live
+ * ones the lookahead for it must not make the emission quadratic */
+static void emit_move(benchmark::State& state)
+{
+    signals::signal<void (std::string)> sig;
+    std::uint64_t counter = 0;
+    std::vector<decltype(sig)::connection> conns;
+    for (std::int64_t i = 0; i < 2 * state.range(0); i++)
+        conns.push_back(sig.connect([&counter](std::string const& s) { counter += s.size(); }));
+    // slots run newest first, the first connected half runs last
+    for (std::int64_t i = 0; i < state.range(0); i++)
+        conns[i].block();
+
+    for (auto _ : state)
+        sig.emit_move(std::string(32, 'x'));
+
+    benchmark::DoNotOptimize(counter);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(emit_move)->Arg(16)->Arg(1024)->Arg(16384);
+
+// muting a slot for an emission instead of disconnecting and connecting it again
+static void block_unblock(benchmark::State& state)
+{
+    signal_t sig;
+    std::uint64_t counter = 0;
+    auto conns = connect_counters(sig, state.range(0), counter);
+    auto conn = sig.connect([&counter] { ++counter; });
+
+    for (auto _ : state)
+    {
+        conn.block();
+        sig();
+        conn.unblock();
+    }
+    benchmark::DoNotOptimize(counter);
+}
+BENCHMARK(block_unblock)->Arg(0)->Arg(1024);
+
+static void connect_disconnect_group(benchmark::State& state)
+{
+    signal_t sig;
+    std::uint64_t counter = 0;
+    std::vector<connection> conns;
+    for (std::int64_t i = 0; i < state.range(0); i++)
+        conns.push_back(sig.connect(static_cast<int>(i % 8), [&counter] { ++counter; }));
+
+    for (auto _ : state)
+    {
+        auto conn = sig.connect(4, [&counter] { ++counter; });
+        benchmark::DoNotOptimize(conn);
+    }
+}
+BENCHMARK(connect_disconnect_group)->Arg(0)->Arg(1024);
+
+static void connect_disconnect_pooled(benchmark::State& state)
+{
+    signal_t sig;
+    std::uint64_t counter = 0;
+    auto conns = connect_counters(sig, state.range(0), counter);
+
+    for (auto _ : state)
+    {
+        auto conn = sig.connect_pooled([&counter] { ++counter; });
+        benchmark::DoNotOptimize(conn);
+    }
+}
+BENCHMARK(connect_disconnect_pooled)->Arg(0)->Arg(1024);
+
+// connections of widgets destroyed one by one, against the same connections in a group
+static void destroy_connections(benchmark::State& state)
+{
+    std::vector<signal_t> sigs(16);
+    std::uint64_t counter = 0;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        std::vector<std::unique_ptr<connection>> conns;
+        for (std::int64_t i = 0; i < state.range(0); i++)
+            conns.push_back(std::make_unique<connection>(sigs[i * sigs.size() / state.range(0)].connect([&counter] { ++counter; })));
+        state.ResumeTiming();
+
+        for (auto& conn : conns)
+            conn.reset();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(destroy_connections)->Arg(16)->Arg(1024);
+
+static void destroy_connection_group(benchmark::State& state)
+{
+    std::vector<signal_t> sigs(16);
+    std::uint64_t counter = 0;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        signal_t::connection_group group;
+        group.reserve(state.range(0));
+        for (std::int64_t i = 0; i < state.range(0); i++)
+            group.connect(sigs[i * sigs.size() / state.range(0)], [&counter] { ++counter; });
+        state.ResumeTiming();
+
+        group.disconnect();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(destroy_connection_group)->Arg(16)->Arg(1024);
+
+// every slot disconnects itself while the emission is on it
+static void disconnect_in_emit(benchmark::State& state)
+{
+    signal_t sig;
+    std::uint64_t counter = 0;
+    std::vector<connection> conns(state.range(0));
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        for (auto& c : conns)
+            c = sig.connect([&counter, &c] { ++counter; c.disconnect(); });
+        state.ResumeTiming();
+
+        sig();
+    }
+
+    benchmark::DoNotOptimize(counter);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(disconnect_in_emit)->Arg(16)->Arg(1024);
+
+static void recursive_emit(benchmark::State& state)
+{
+    signal_t sig;
+    std::int64_t depth = 0;
+    auto const max_depth = state.range(0);
+    auto conn = sig.connect([&]
+    {
+        if (++depth < max_depth)
+            sig();
+    });
+
+    for (auto _ : state)
+    {
+        depth = 0;
+        sig();
+    }
+
+    state.SetItemsProcessed(state.iterations() * max_depth);
+}
+BENCHMARK(recursive_emit)->Arg(1)->Arg(16)->Arg(64);
+
+// moves the executing connection while range(0) emissions are walking it
+static void move_in_emit(benchmark::State& state)
+{
+    signal_t sig;
+    std::int64_t depth = 0;
+    auto const walkers = state.range(0);
+    connection a, b;
+    a = sig.connect([&]
+    {
+        if (++depth < walkers)
+        {
+            sig();
+            return;
+        }
+        // the closure is moved together with the connection, keep the references local
+        auto& from = a;
+        auto& to = b;
+        for (int i = 0; i < 8; i++)
+        {
+            to = std::move(from);
+            from = std::move(to);
+        }
+    });
+
+    for (auto _ : state)
+    {
+        depth = 0;
+        sig();
+    }
+
+    state.SetItemsProcessed(state.iterations() * 16);
+}
+BENCHMARK(move_in_emit)->Arg(1)->Arg(16)->Arg(64);
+
+namespace
+{
+    struct deferred_policy : signals::default_policy
+    {
+        static constexpr bool deferred_disconnect = true;
+    };
+
+    struct tracked : signals::trackable
+    {};
+}
+
+// times destroying an object tracking 256 slots while range(0) emissions are walking them
+template <typename Signal>
+static void destroy_tracked_in_emit(benchmark::State& state)
+{
+    Signal sig;
+    std::int64_t depth = 0;
+    auto const walkers = state.range(0);
+    std::uint64_t counter = 0;
+    std::unique_ptr<tracked> obj;
+    double seconds = 0;
+    auto conn = sig.connect([&]
+    {
+        if (++depth < walkers)
+        {
+            sig();
+            return;
+        }
+        auto begin = std::chrono::steady_clock::now();
+        obj.reset();
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    });
+
+    for (auto _ : state)
+    {
+        obj = std::make_unique<tracked>();
+        for (int i = 0; i < 256; i++)
+            sig.connect_tracked(*obj, [&counter] { ++counter; });
+        depth = 0;
+        sig();
+        state.SetIterationTime(seconds);
+    }
+
+    state.SetItemsProcessed(state.iterations() * 256);
+}
+BENCHMARK_TEMPLATE(destroy_tracked_in_emit, signal_t)->Arg(1)->Arg(16)->Arg(64)->UseManualTime();
+BENCHMARK_TEMPLATE(destroy_tracked_in_emit, signals::signal<void(), signals::default_inline_bytes, deferred_policy>)->Arg(1)->Arg(16)->Arg(64)->UseManualTime();
+
+// a frame emitting changed(id) repeatedly for a few ids, slots either run on every emit or once per id
+static void emit_changed_direct(benchmark::State& state)
+{
+    signals::signal<void(std::size_t, int)> sig;
+    std::uint64_t counter = 0;
+    std::vector<signals::signal<void(std::size_t, int)>::connection> conns;
+    for (int i = 0; i < 4; i++)
+        conns.push_back(sig.connect([&counter](std::size_t id, int v) { counter += id + v; }));
+
+    for (auto _ : state)
+        for (int round = 0; round < state.range(0); round++)
+            for (std::size_t id = 0; id < 64; id++)
+                sig(id, round);
+
+    benchmark::DoNotOptimize(counter);
+    state.SetItemsProcessed(state.iterations() * state.range(0) * 64);
+}
+BENCHMARK(emit_changed_direct)->Arg(1)->Arg(100);
+
+template <typename Keys>
+static void emit_changed_coalesced(benchmark::State& state)
+{
+    signals::coalescing_signal<void(std::size_t, int), signals::coalesce::last_value, Keys> sig;
+    std::uint64_t counter = 0;
+    std::vector<signals::signal<void(std::size_t, int)>::connection> conns;
+    for (int i = 0; i < 4; i++)
+        conns.push_back(sig.connect([&counter](std::size_t id, int v) { counter += id + v; }));
+
+    for (auto _ : state)
+    {
+        for (int round = 0; round < state.range(0); round++)
+            for (std::size_t id = 0; id < 64; id++)
+                sig(id, round);
+        sig.flush();
+    }
+
+    benchmark::DoNotOptimize(counter);
+    state.SetItemsProcessed(state.iterations() * state.range(0) * 64);
+}
+BENCHMARK_TEMPLATE(emit_changed_coalesced, signals::coalesce::hashed_keys)->Arg(1)->Arg(100);
+BENCHMARK_TEMPLATE(emit_changed_coalesced, signals::coalesce::dense_keys<64>)->Arg(1)->Arg(100);
+
+#if defined(__linux__)
+// publishing into the shared ring and reading it back through a subscriber
+static void emit_shm(benchmark::State& state)
+{
+    auto name = "/signals_bench_" + std::to_string(::getpid());
+    signals::shm_signal<void(std::uint64_t, double)> sig(name, 1024);
+    signals::shm_subscriber<void(std::uint64_t, double)> sub(name);
+    std::uint64_t counter = 0;
+    auto conn = sub.connect([&counter](std::uint64_t id, double) { counter += id; });
+
+    for (auto _ : state)
+    {
+        for (std::uint64_t i = 0; i < 64; i++)
+            sig(i, 1.0);
+        sub.dispatch();
+    }
+
+    benchmark::DoNotOptimize(counter);
+    state.SetItemsProcessed(state.iterations() * 64);
+}
+BENCHMARK(emit_shm);
+
+// range(0) slots on every shard of a shard per core, each connected from the shard's cpu
+static void emit_sharded(benchmark::State& state)
+{
+    signals::sharded_signal<void(std::uint64_t)> sig(signals::shard_by::core);
+    std::vector<std::uint64_t> counters(sig.shard_count() * 8);
+    std::vector<signals::sharded_signal<void(std::uint64_t)>::connection> conns;
+    for (std::size_t shard = 0; shard < sig.shard_count(); shard++)
+        for (std::int64_t i = 0; i < state.range(0); i++)
+            conns.push_back(sig.connect(shard, [c = &counters[shard * 8]](std::uint64_t v) { *c += v; }));
+
+    for (auto _ : state)
+        sig(1);
+
+    benchmark::DoNotOptimize(counters.data());
+    state.SetItemsProcessed(state.iterations() * state.range(0) * sig.shard_count());
+}
+BENCHMARK(emit_sharded)->Arg(1)->Arg(1024)->UseRealTime();
+#endif
+
+BENCHMARK_MAIN();
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "signals.h"
+
+// c++20 only: awaiting emissions and coroutine slots
+namespace signals
+{
+
+namespace detail
+{
+
+// completion of the tasks started by one emit_async
+struct join_state
+{
+    // one for every running task and one for the emitter itself
+    std::atomic<std::size_t> pending{0};
+    std::coroutine_handle<> waiter;
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+
+    void fail(std::exception_ptr e) noexcept
+    {
+        if (!failed.exchange(true, std::memory_order_relaxed))
+            error = std::move(e);
+    }
+
+    void finish() noexcept
+    {
+        if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            waiter.resume();
+    }
+};
+
+}
+
+/* coroutine slot of a signal<task(Args...)>
+ *
+ * the body does not start until the task is handed to emit_async or detached,
+ * the frame frees itself when the body finishes */
+class task
+{
+public:
+    struct promise_type
+    {
+        detail::join_state* join = nullptr;
+
+        task get_return_object() noexcept
+        {
+            return task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        auto final_suspend() noexcept
+        {
+            struct finisher
+            {
+                bool await_ready() const noexcept
+                {
+                    return false;
+                }
+                void await_suspend(std::coroutine_handle<promise_type> h) noexcept
+                {
+                    auto* join = h.promise().join;
+                    h.destroy();
+                    if (join != nullptr)
+                        join->finish();
+                }
+                void await_resume() const noexcept
+                {}
+            };
+            return finisher{};
+        }
+
+        void return_void() noexcept
+        {}
+
+        // a detached task has nobody to report to
+        void unhandled_exception() noexcept
+        {
+            if (join == nullptr)
+                std::terminate();
+            join->fail(std::current_exception());
+        }
+    };
+
+    task() = default;
+    ~task()
+    {
+        if (handle)
+            handle.destroy();
+    }
+
+    task(task const&) = delete;
+    task(task&& r) noexcept
+    : handle(std::exchange(r.handle, nullptr))
+    {}
+
+    task& operator=(task const&) = delete;
+    task& operator=(task&& r) noexcept
+    {
+        if (this == &r)
+            return *this;
+        if (handle)
+            handle.destroy();
+        handle = std::exchange(r.handle, nullptr);
+        return *this;
+    }
+
+    // runs the body without anyone waiting for it, it must not throw
+    void detach() && noexcept
+    {
+        if (handle)
+            std::exchange(handle, nullptr).resume();
+    }
+
+private:
+    template <typename Signal>
+    friend struct emit_awaiter;
+
+    std::coroutine_handle<promise_type> handle;
+
+    explicit task(std::coroutine_handle<promise_type> handle) noexcept
+    : handle(handle)
+    {}
+
+    void start(detail::join_state& join) noexcept
+    {
+        if (!handle)
+            return;
+        handle.promise().join = &join;
+        join.pending.fetch_add(1, std::memory_order_relaxed);
+        std::exchange(handle, nullptr).resume();
+    }
+};
+
+/* result of sig.next(), resumes the awaiting coroutine from inside the next emission
+ *
+ * the waiter is an ordinary connection living in the coroutine frame, its slot is one
+ * pointer and always inline, so a wait does not allocate. the arguments are copied
+ * before the coroutine resumes. a coroutine waiting on a destroyed signal is never resumed */
+template <typename... Args, std::size_t InlineBytes, typename Policy>
+struct next_awaiter<signal<void (Args...), InlineBytes, Policy>>
+{
+private:
+    using signal_type = signal<void (Args...), InlineBytes, Policy>;
+
+    struct waker
+    {
+        next_awaiter* self;
+
+        void operator()(arg_ref<Args>... a) const
+        {
+            auto h = self->handle;
+            self->value.emplace(a...);
+            self->conn.disconnect();
+            h.resume();
+        }
+    };
+
+    signal_type* sig;
+    std::coroutine_handle<> handle;
+    std::optional<std::tuple<std::decay_t<Args>...>> value;
+    typename signal_type::connection conn;
+public:
+    explicit next_awaiter(signal_type& sig) noexcept
+    : sig(&sig)
+    {}
+
+    next_awaiter(next_awaiter const&) = delete;
+    next_awaiter& operator=(next_awaiter const&) = delete;
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    /* connected in front, so an emission that is already running does not wake us.
+     * if connecting throws, the exception is rethrown from the co_await */
+    void await_suspend(std::coroutine_handle<> h)
+    {
+        handle = h;
+        conn = sig->connect(waker{this});
+    }
+
+    // nothing for void(), the argument for a single one, a tuple otherwise
+    auto await_resume()
+    {
+        if constexpr (sizeof...(Args) == 1)
+            return std::get<0>(std::move(*value));
+        else if constexpr (sizeof...(Args) > 1)
+            return std::move(*value);
+    }
+};
+
+/* result of sig.emit_async(args...), starts every coroutine slot and resumes the
+ * awaiting coroutine once all of them have finished, possibly on another thread.
+ * the first exception escaping a slot is rethrown from the co_await */
+template <typename... Args, std::size_t InlineBytes, typename Policy>
+struct emit_awaiter<signal<task (Args...), InlineBytes, Policy>>
+{
+private:
+    using signal_type = signal<task (Args...), InlineBytes, Policy>;
+
+    struct starter
+    {
+        detail::join_state* join;
+
+        bool operator()(task&& t) noexcept
+        {
+            t.start(*join);
+            return true;
+        }
+        void result() const noexcept
+        {}
+    };
+
+    signal_type* sig;
+    std::tuple<arg_ref<Args>...> args;
+    detail::join_state join;
+public:
+    emit_awaiter(signal_type& sig, arg_ref<Args>... a) noexcept
+    : sig(&sig)
+    , args(a...)
+    {}
+
+    emit_awaiter(emit_awaiter const&) = delete;
+    emit_awaiter& operator=(emit_awaiter const&) = delete;
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> h) noexcept
+    {
+        join.waiter = h;
+        join.pending.store(1, std::memory_order_relaxed);
+        try
+        {
+            std::apply([this](auto const&... a) { sig->combine(starter{&join}, a...); }, args);
+        }
+        catch (...)
+        {
+            join.fail(std::current_exception());
+        }
+        return join.pending.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+
+    void await_resume()
+    {
+        if (join.error)
+            std::rethrow_exception(join.error);
+    }
+};
+
+}
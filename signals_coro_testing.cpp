@@ -0,0 +1,160 @@
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "signals_coro.h"
+
+namespace
+{
+
+signals::task count_emissions(signals::signal<void()>& sig, int times, int& got)
+{
+    for (int i = 0; i < times; i++)
+    {
+        co_await sig.next();
+        ++got;
+    }
+}
+
+signals::task collect_values(signals::signal<void (int)>& sig, int times, std::vector<int>& got)
+{
+    for (int i = 0; i < times; i++)
+        got.push_back(co_await sig.next());
+}
+
+signals::task collect_tuples(signals::signal<void (int, std::string)>& sig, std::vector<std::tuple<int, std::string>>& got)
+{
+    got.push_back(co_await sig.next());
+}
+
+signals::task await_all(signals::signal<signals::task (int)>& sig, int v, bool& done)
+{
+    co_await sig.emit_async(v);
+    done = true;
+}
+
+signals::task await_error(signals::signal<signals::task ()>& sig, std::string& error)
+{
+    try
+    {
+        co_await sig.emit_async();
+    }
+    catch (std::runtime_error const& e)
+    {
+        error = e.what();
+    }
+}
+
+}
+
+TEST(coro_signal_testing, next)
+{
+    signals::signal<void()> sig;
+    int got = 0;
+    count_emissions(sig, 2, got).detach();
+
+    EXPECT_EQ(0, got);
+    sig();
+    EXPECT_EQ(1, got);
+    sig();
+    sig();
+    EXPECT_EQ(2, got);
+    EXPECT_TRUE(sig.lst.empty());
+}
+
+TEST(coro_signal_testing, next_value)
+{
+    signals::signal<void (int)> sig;
+    std::vector<int> got;
+    uint32_t calls = 0;
+    auto conn = sig.connect([&](int) { ++calls; });
+    collect_values(sig, 3, got).detach();
+
+    // the waiter reconnects while the emission runs, it is woken by the next one only
+    sig(1);
+    sig(2);
+    sig(3);
+    sig(4);
+
+    EXPECT_EQ((std::vector<int>{1, 2, 3}), got);
+    EXPECT_EQ(4, calls);
+}
+
+TEST(coro_signal_testing, next_tuple)
+{
+    signals::signal<void (int, std::string)> sig;
+    std::vector<std::tuple<int, std::string>> got;
+    collect_tuples(sig, got).detach();
+
+    sig(5, "five");
+
+    ASSERT_EQ(1, got.size());
+    EXPECT_EQ(std::make_tuple(5, std::string("five")), got[0]);
+}
+
+TEST(coro_signal_testing, next_from_several_coroutines)
+{
+    signals::signal<void()> sig;
+    int got1 = 0;
+    int got2 = 0;
+    count_emissions(sig, 1, got1).detach();
+    count_emissions(sig, 2, got2).detach();
+
+    sig();
+    sig();
+
+    EXPECT_EQ(1, got1);
+    EXPECT_EQ(2, got2);
+}
+
+TEST(coro_signal_testing, emit_async)
+{
+    signals::signal<signals::task (int)> sig;
+    signals::signal<void()> go;
+    int sum = 0;
+    auto conn1 = sig.connect([&](int v) -> signals::task { co_await go.next(); sum += v; });
+    auto conn2 = sig.connect([&](int v) -> signals::task { sum += 10 * v; co_return; });
+
+    bool done = false;
+    await_all(sig, 2, done).detach();
+
+    EXPECT_FALSE(done);
+    EXPECT_EQ(20, sum);
+    go();
+    EXPECT_TRUE(done);
+    EXPECT_EQ(22, sum);
+}
+
+TEST(coro_signal_testing, emit_async_no_slots)
+{
+    signals::signal<signals::task (int)> sig;
+    bool done = false;
+    await_all(sig, 1, done).detach();
+
+    EXPECT_TRUE(done);
+}
+
+TEST(coro_signal_testing, emit_async_exception)
+{
+    signals::signal<signals::task ()> sig;
+    signals::signal<void()> go;
+    int finished = 0;
+    auto conn1 = sig.connect([&]() -> signals::task { co_await go.next(); ++finished; });
+    auto conn2 = sig.connect([&]() -> signals::task { co_await go.next(); throw std::runtime_error("slot failed"); });
+
+    std::string error;
+    await_error(sig, error).detach();
+
+    EXPECT_TRUE(error.empty());
+    go();
+    EXPECT_EQ(1, finished);
+    EXPECT_EQ("slot failed", error);
+}
+
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
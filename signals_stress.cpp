@@ -0,0 +1,276 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "signals.h"
+#include "dense_signal.h"
+
+/* randomized connect, disconnect, move, nested emit and signal destruction, run from the
+ * top level and from inside slots, checked call by call against a model of what every
+ * emission has to invoke. prints the throughput of each storage mode and of dense_signal.
+ *
+ *   signal_stress [--seed n] [--ops n] [--signals n] [--handles n] [--depth n] */
+namespace
+{
+
+struct options
+{
+    std::uint64_t seed = 1;
+    std::size_t ops = 200000;
+    std::size_t signals = 200;
+    std::size_t handles = 5000;
+    std::size_t depth = 4;
+};
+
+struct unrolled_policy : signals::default_policy
+{
+    using container = intrusive::unrolled;
+};
+
+struct compact_policy : signals::default_policy
+{
+    static constexpr bool compact_connections = true;
+};
+
+struct counts
+{
+    std::uint64_t ops = 0;
+    std::uint64_t emits = 0;
+    std::uint64_t calls = 0;
+};
+
+/* the model: ids are never reused, a signal lists the ids connected to it newest first.
+ * an emission has to invoke, in order, the ids listed when it started that are still
+ * connected when it gets to them, and nothing once its signal is destroyed */
+template <typename Signal>
+class harness
+{
+private:
+    using connection = typename Signal::connection;
+
+    struct frame
+    {
+        std::size_t sig;
+        std::uint64_t serial;
+        std::vector<std::size_t> expected;
+        std::size_t pos = 0;
+        bool dead = false;
+    };
+
+    static constexpr std::size_t none = std::size_t(-1);
+
+    options const& opt;
+    std::mt19937_64 rng;
+    std::vector<std::unique_ptr<Signal>> sigs;
+    std::vector<connection> conns;
+
+    std::vector<std::vector<std::size_t>> listed;
+    std::vector<std::size_t> sig_of;
+    std::vector<char> alive;
+    std::vector<std::size_t> id_of;
+    std::vector<frame> frames;
+    std::uint64_t serial = 0;
+    std::size_t step = 0;
+    counts n;
+
+    [[noreturn]] void fail(char const* what, std::size_t id)
+    {
+        std::fprintf(stderr, "seed %llu op %zu: %s (id %zu)\n", (unsigned long long)opt.seed, step, what, id);
+        std::exit(1);
+    }
+
+    std::size_t pick(std::size_t count)
+    {
+        return std::size_t(rng() % count);
+    }
+
+    void kill(std::size_t h)
+    {
+        if (id_of[h] != none)
+            alive[id_of[h]] = false;
+        id_of[h] = none;
+    }
+
+    void connect(std::size_t s, std::size_t h)
+    {
+        auto id = sig_of.size();
+        sig_of.push_back(s);
+        alive.push_back(true);
+        kill(h);
+        conns[h] = sigs[s]->connect([self = this, id](std::uint64_t emission) { self->called(id, emission); });
+        id_of[h] = id;
+        auto& l = listed[s];
+        // keep the lists short, dead ids are only needed by frames that copied them already
+        if (l.size() > 64)
+            l.erase(std::remove_if(l.begin(), l.end(), [&](std::size_t i) { return !alive[i]; }), l.end());
+        l.insert(l.begin(), id);
+    }
+
+    void disconnect(std::size_t h)
+    {
+        conns[h].disconnect();
+        kill(h);
+    }
+
+    void move(std::size_t from, std::size_t to)
+    {
+        if (from == to)
+            return;
+        kill(to);
+        conns[to] = std::move(conns[from]);
+        id_of[to] = id_of[from];
+        id_of[from] = none;
+    }
+
+    void destroy(std::size_t s)
+    {
+        sigs[s] = std::make_unique<Signal>();
+        for (auto id : listed[s])
+            alive[id] = false;
+        listed[s].clear();
+        for (auto& f : frames)
+            if (f.sig == s)
+                f.dead = true;
+        for (auto& id : id_of)
+            if (id != none && sig_of[id] == s)
+                id = none;
+    }
+
+    void emit(std::size_t s)
+    {
+        frame f{s, ++serial, {}};
+        for (auto id : listed[s])
+            if (alive[id])
+                f.expected.push_back(id);
+        frames.push_back(std::move(f));
+        n.emits++;
+        (*sigs[s])(serial_of_top());
+        auto& top = frames.back();
+        if (!top.dead)
+        {
+            while (top.pos < top.expected.size() && !alive[top.expected[top.pos]])
+                top.pos++;
+            if (top.pos != top.expected.size())
+                fail("emission skipped a connected slot", top.expected[top.pos]);
+        }
+        frames.pop_back();
+    }
+
+    std::uint64_t serial_of_top() const noexcept
+    {
+        return frames.back().serial;
+    }
+
+    void called(std::size_t id, std::uint64_t emission)
+    {
+        n.calls++;
+        if (frames.empty())
+            fail("slot called outside of an emission", id);
+        auto& f = frames.back();
+        if (f.dead)
+            fail("slot called after its signal was destroyed", id);
+        if (emission != f.serial || sig_of[id] != f.sig)
+            fail("slot called by the wrong emission", id);
+        while (f.pos < f.expected.size() && !alive[f.expected[f.pos]])
+            f.pos++;
+        if (f.pos == f.expected.size() || f.expected[f.pos] != id)
+            fail("slot called out of order", id);
+        f.pos++;
+
+        // slots act less often the deeper they run, so nesting stays bounded
+        if (frames.size() <= opt.depth && pick(4 * frames.size()) == 0)
+            act();
+    }
+
+    void act()
+    {
+        n.ops++;
+        auto s = pick(sigs.size());
+        auto h = pick(conns.size());
+        auto r = pick(100);
+        if (r < 35)
+            connect(s, h);
+        else if (r < 55)
+            disconnect(h);
+        else if (r < 75)
+            move(h, pick(conns.size()));
+        else if (r < 99)
+            emit(s);
+        else
+            destroy(s);
+    }
+public:
+    explicit harness(options const& opt)
+    : opt(opt)
+    , rng(opt.seed)
+    , conns(opt.handles)
+    , listed(opt.signals)
+    , id_of(opt.handles, none)
+    {
+        for (std::size_t i = 0; i < opt.signals; i++)
+            sigs.push_back(std::make_unique<Signal>());
+    }
+
+    counts run()
+    {
+        for (step = 0; step < opt.ops; step++)
+            act();
+        return n;
+    }
+};
+
+template <typename Signal>
+void run(char const* mode, options const& opt)
+{
+    harness<Signal> h(opt);
+    auto begin = std::chrono::steady_clock::now();
+    auto n = h.run();
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::printf("%-9s %10llu ops %10llu emits %12llu slot calls %8.3f s %12.0f ops/s %12.0f calls/s\n",
+                mode, (unsigned long long)n.ops, (unsigned long long)n.emits, (unsigned long long)n.calls,
+                seconds, double(n.ops) / seconds, double(n.calls) / seconds);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    options opt;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        auto value = std::strtoull(argv[i + 1], nullptr, 10);
+        if (std::strcmp(argv[i], "--seed") == 0)
+            opt.seed = value;
+        else if (std::strcmp(argv[i], "--ops") == 0)
+            opt.ops = value;
+        else if (std::strcmp(argv[i], "--signals") == 0)
+            opt.signals = value;
+        else if (std::strcmp(argv[i], "--handles") == 0)
+            opt.handles = value;
+        else if (std::strcmp(argv[i], "--depth") == 0)
+            opt.depth = value;
+        else
+        {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (opt.signals == 0 || opt.handles == 0)
+    {
+        std::fprintf(stderr, "need at least one signal and one handle\n");
+        return 2;
+    }
+
+    using signal_type = void (std::uint64_t);
+    run<signals::signal<signal_type>>("linked", opt);
+    run<signals::signal<signal_type, signals::default_inline_bytes, unrolled_policy>>("unrolled", opt);
+    run<signals::signal<signal_type, signals::default_inline_bytes, compact_policy>>("compact", opt);
+    run<signals::dense_signal<signal_type>>("dense", opt);
+    return 0;
+}
@@ -1,5 +1,29 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
 #include <gtest/gtest.h>
 #include "signals.h"
+#include "dense_signal.h"
+#include "coalescing_signal.h"
+#include "concurrent_signal.h"
+#include "queued_connection.h"
+#if defined(__linux__)
+#include "sharded_signal.h"
+#include "shm_signal.h"
+#include <sys/wait.h>
+#endif
+#include "static_signal.h"
+#include "tracing.h"
 
 TEST(signal_testing, trivial)
 {
@@ -274,6 +298,2143 @@ TEST(signal_testing, move_in_emit_02)
     EXPECT_EQ(1, got1);
 }
 
+TEST(signal_testing, move_in_emit_03)
+{
+    using connection = signals::signal<void()>::connection;
+
+    signals::signal<void()> sig;
+    uint32_t got1 = 0;
+    uint32_t got2 = 0;
+    connection conn1 = sig.connect([&] { ++got1; });
+    connection conn2_old;
+    connection conn2_new;
+
+    conn2_old = sig.connect([&]
+    {
+        ++got2;
+        auto& ref_copy = conn2_new;
+        ref_copy = std::move(conn2_old);
+    });
+
+    sig();
+    EXPECT_EQ(1, got2);
+    EXPECT_EQ(1, got1);
+}
+
+TEST(signal_testing, disconnect_next_in_emit)
+{
+    using connection = signals::signal<void()>::connection;
+
+    signals::signal<void()> sig;
+    uint32_t got1 = 0;
+    uint32_t got2 = 0;
+    uint32_t got3 = 0;
+    connection conn1 = sig.connect([&] { ++got1; });
+    connection conn2 = sig.connect([&] { ++got2; });
+    connection conn3 = sig.connect([&] { ++got3; conn3.disconnect(); conn2.disconnect(); });
+
+    sig();
+    EXPECT_EQ(1, got3);
+    EXPECT_EQ(0, got2);
+    EXPECT_EQ(1, got1);
+}
+
+TEST(signal_testing, inline_slot)
+{
+    using slot_type = signals::signal<void()>::slot_type;
+    signals::signal<void()> sig;
+    uint32_t a = 0, b = 0, c = 0, d = 0, e = 0;
+    auto fn = [&a, &b, &c, &d, &e] { ++a; ++b; ++c; ++d; ++e; };
+    static_assert(slot_type::fits_inline<decltype(fn)>);
+
+    auto conn_old = sig.connect(fn);
+    auto conn_new = std::move(conn_old);
+    sig();
+
+    EXPECT_EQ(1, a);
+    EXPECT_EQ(1, e);
+}
+
+TEST(signal_testing, heap_slot)
+{
+    signals::signal<void (), 0> sig;
+    uint32_t got = 0;
+    std::array<uint32_t*, 8> big;
+    big.fill(&got);
+    auto fn = [big] { for (auto p : big) ++*p; };
+    static_assert(!signals::signal<void (), 0>::slot_type::fits_inline<decltype(fn)>);
+
+    auto conn_old = sig.connect(fn);
+    auto conn_new = std::move(conn_old);
+    sig();
+
+    EXPECT_EQ(8, got);
+}
+
+TEST(signal_testing, move_only_slot)
+{
+    signals::signal<void (int)> sig;
+    auto target = std::make_unique<int>(0);
+    auto conn = sig.connect([p = std::move(target)](int v) { *p += v; EXPECT_EQ(5, *p); });
+
+    sig(5);
+}
+
+TEST(signal_testing, pooled_connection)
+{
+    signals::signal<void()> sig;
+    uint32_t got1 = 0;
+    auto conn1 = sig.connect_pooled([&] { ++got1; });
+    uint32_t got2 = 0;
+    auto conn2_old = sig.connect_pooled([&] { ++got2; });
+    auto conn2_new = std::move(conn2_old);
+
+    sig();
+
+    EXPECT_EQ(1, got1);
+    EXPECT_EQ(1, got2);
+
+    conn1.disconnect();
+    conn1 = sig.connect_pooled([&] { got1 += 10; });
+    sig();
+
+    EXPECT_EQ(11, got1);
+    EXPECT_EQ(2, got2);
+}
+
+TEST(signal_testing, pooled_disconnect_in_emit)
+{
+    using connection = signals::signal<void()>::pooled_connection;
+    signals::signal<void()> sig;
+    uint32_t got1 = 0;
+    connection conn1 = sig.connect_pooled([&] { ++got1; });
+    uint32_t got2 = 0;
+    connection conn2;
+    conn2 = sig.connect_pooled([&] { ++got2; conn2.disconnect(); });
+    uint32_t got3 = 0;
+    connection conn3 = sig.connect_pooled([&] { ++got3; });
+
+    sig();
+    sig();
+
+    EXPECT_EQ(2, got1);
+    EXPECT_EQ(1, got2);
+    EXPECT_EQ(2, got3);
+}
+
+TEST(signal_testing, pooled_destroy_signal_before_connection)
+{
+    auto sig = std::make_unique<signals::signal<void()>>();
+    uint32_t got1 = 0;
+    auto conn1_old = sig->connect_pooled([&] { ++got1; });
+    uint32_t got2 = 0;
+    auto conn2 = sig->connect_pooled([&] { ++got2; sig.reset(); });
+
+    (*sig)();
+    EXPECT_EQ(1, got2);
+
+    auto conn1_new = std::move(conn1_old);
+}
+
+TEST(signal_testing, connection_group)
+{
+    signals::signal<void()> sig1;
+    signals::signal<void()> sig2;
+    uint32_t got = 0;
+    auto kept = sig1.connect([&] { got += 100; });
+    {
+        signals::signal<void()>::connection_group group;
+        for (int i = 0; i < 3; i++)
+        {
+            group.connect(sig1, [&] { ++got; });
+            group.connect(sig2, [&] { ++got; });
+        }
+        group.add(sig2.connect([&] { ++got; }));
+        EXPECT_EQ(7, group.size());
+
+        sig1();
+        sig2();
+        EXPECT_EQ(107, got);
+    }
+    sig1();
+    sig2();
+
+    EXPECT_EQ(207, got);
+    EXPECT_FALSE(sig1.lst.empty());
+    EXPECT_TRUE(sig2.lst.empty());
+}
+
+TEST(signal_testing, connection_group_disconnect_in_emit)
+{
+    signals::signal<void()> sig;
+    signals::signal<void()>::connection_group group;
+    uint32_t got1 = 0;
+    group.connect(sig, [&] { ++got1; });
+    uint32_t got2 = 0;
+    group.connect(sig, [&] { ++got2; group.disconnect(); });
+    uint32_t got3 = 0;
+    group.connect(sig, [&] { ++got3; });
+
+    sig();
+    sig();
+
+    EXPECT_EQ(0, got1);
+    EXPECT_EQ(1, got2);
+    EXPECT_EQ(1, got3);
+    EXPECT_EQ(0, group.size());
+}
+
+TEST(static_signal_testing, trivial)
+{
+    std::vector<int> got;
+    auto sig = signals::make_static_signal<void (int)>(
+            [&](int v) { got.push_back(v); },
+            [&](int const& v) { got.push_back(v * 10); });
+    static_assert(decltype(sig)::size == 2);
+
+    sig(1);
+    sig(2);
+
+    EXPECT_EQ((std::vector<int>{1, 10, 2, 20}), got);
+}
+
+TEST(static_signal_testing, stateful_slots)
+{
+    struct counter
+    {
+        uint32_t calls = 0;
+        void operator()() { ++calls; }
+    };
+    signals::static_signal<void(), counter, counter> sig;
+
+    sig();
+    sig();
+
+    EXPECT_EQ(2, sig.get<0>().calls);
+    EXPECT_EQ(2, sig.get<1>().calls);
+}
+
+TEST(dense_signal_testing, trivial)
+{
+    signals::dense_signal<void (int)> sig;
+    uint32_t got1 = 0;
+    auto conn1 = sig.connect([&](int v) { got1 += v; });
+    uint32_t got2 = 0;
+    auto conn2_old = sig.connect([&](int v) { got2 += v; });
+    auto conn2_new = std::move(conn2_old);
+
+    sig(1);
+    conn1.disconnect();
+    sig(2);
+
+    EXPECT_EQ(1, got1);
+    EXPECT_EQ(3, got2);
+}
+
+TEST(dense_signal_testing, disconnect_in_emit)
+{
+    using connection = signals::dense_signal<void()>::connection;
+    signals::dense_signal<void()> sig;
+    uint32_t got1 = 0;
+    auto conn1 = std::make_unique<connection>(sig.connect([&] { ++got1; }));
+    uint32_t got2 = 0;
+    std::unique_ptr<connection> conn2;
+    conn2.reset(new connection(sig.connect([&] { ++got2; conn2.reset(); conn1.reset(); })));
+    uint32_t got3 = 0;
+    auto conn3 = std::make_unique<connection>(sig.connect([&] { ++got3; }));
+
+    sig();
+
+    EXPECT_EQ(0, got1);
+    EXPECT_EQ(1, got2);
+    EXPECT_EQ(1, got3);
+
+    sig();
+
+    EXPECT_EQ(0, got1);
+    EXPECT_EQ(1, got2);
+    EXPECT_EQ(2, got3);
+}
+
+TEST(dense_signal_testing, connect_in_emit)
+{
+    using connection = signals::dense_signal<void()>::connection;
+    signals::dense_signal<void()> sig;
+    uint32_t got1 = 0;
+    uint32_t got2 = 0;
+    connection conn2;
+    auto conn1 = sig.connect([&]
+    {
+        ++got1;
+        if (got1 == 1)
+            conn2 = sig.connect([&] { ++got2; });
+    });
+
+    sig();
+    EXPECT_EQ(0, got2);
+
+    sig();
+    EXPECT_EQ(2, got1);
+    EXPECT_EQ(1, got2);
+}
+
+TEST(dense_signal_testing, connect_in_emit_reaches_nested_emit)
+{
+    using connection = signals::dense_signal<void()>::connection;
+    signals::dense_signal<void()> sig;
+    uint32_t got1 = 0;
+    uint32_t got2 = 0;
+    uint32_t got3 = 0;
+    connection conn2, conn3;
+    auto conn1 = sig.connect([&]
+    {
+        if (++got1 != 1)
+            return;
+        conn2 = sig.connect([&]
+        {
+            // connected inside the nested emission, misses it and the outer one
+            if (++got2 == 1)
+                conn3 = sig.connect([&] { ++got3; });
+        });
+        sig();
+    });
+
+    sig();
+    EXPECT_EQ(2, got1);
+    EXPECT_EQ(1, got2);
+    EXPECT_EQ(0, got3);
+
+    sig();
+    EXPECT_EQ(3, got1);
+    EXPECT_EQ(2, got2);
+    EXPECT_EQ(1, got3);
+}
+
+TEST(dense_signal_testing, destroy_signal_in_emit)
+{
+    using connection = signals::dense_signal<void()>::connection;
+
+    auto sig = std::make_unique<signals::dense_signal<void()>>();
+    uint32_t got1 = 0;
+    connection conn1(sig->connect([&] { ++got1; }));
+    uint32_t got2 = 0;
+    connection conn2(sig->connect([&] { ++got2; sig.reset(); }));
+    uint32_t got3 = 0;
+    connection conn3(sig->connect([&] { ++got3; }));
+
+    (*sig)();
+
+    EXPECT_EQ(1, got2);
+    EXPECT_EQ(0, got1);
+}
+
+TEST(dense_signal_testing, recursive_emit)
+{
+    auto sig = std::make_unique<signals::dense_signal<void()>>();
+    uint32_t got1 = 0;
+    auto conn1 = sig->connect([&] { ++got1; });
+    uint32_t got2 = 0;
+    auto conn2 = sig->connect([&]
+    {
+        ++got2;
+        if (got2 == 1)
+            (*sig)();
+        else if (got2 == 2)
+            sig.reset();
+        else
+            assert(false);
+    });
+    uint32_t got3 = 0;
+    auto conn3 = sig->connect([&] { ++got3; });
+
+    (*sig)();
+
+    EXPECT_EQ(2, got2);
+}
+
+TEST(dense_signal_testing, move_in_emit)
+{
+    using connection = signals::dense_signal<void()>::connection;
+
+    signals::dense_signal<void()> sig;
+    uint32_t got1 = 0;
+    uint32_t got2 = 0;
+    std::unique_ptr<connection> conn1_old;
+    std::unique_ptr<connection> conn1_new;
+    std::unique_ptr<connection> conn2;
+
+    conn1_old = std::make_unique<connection>(sig.connect([&] { ++got1; }));
+    conn2 = std::make_unique<connection>(sig.connect([&]
+    {
+        ++got2;
+        if (got2 != 1)
+            return;
+        conn1_new = std::make_unique<connection>(std::move(*conn1_old));
+        conn1_old.reset();
+    }));
+
+    sig();
+    EXPECT_EQ(1, got1);
+
+    sig();
+    EXPECT_EQ(2, got1);
+    EXPECT_EQ(2, got2);
+}
+
+TEST(dense_signal_testing, compaction)
+{
+    using connection = signals::dense_signal<void()>::connection;
+
+    signals::dense_signal<void()> sig;
+    uint32_t got = 0;
+    std::vector<connection> conns;
+    for (int i = 0; i < 16; i++)
+        conns.push_back(sig.connect([&] { ++got; }));
+    for (int i = 0; i < 16; i += 2)
+        conns[i].disconnect();
+    conns.erase(conns.begin(), conns.begin() + 12);
+
+    sig();
+    EXPECT_EQ(2, got);
+}
+
+TEST(concurrent_signal_testing, trivial)
+{
+    signals::concurrent_signal<void (int)> sig;
+    uint32_t got1 = 0;
+    auto conn1 = sig.connect([&](int v) { got1 += v; });
+    uint32_t got2 = 0;
+    auto conn2_old = sig.connect([&](int v) { got2 += v; });
+    auto conn2_new = std::move(conn2_old);
+
+    sig(1);
+    conn1.disconnect();
+    sig(2);
+
+    EXPECT_EQ(1, got1);
+    EXPECT_EQ(3, got2);
+}
+
+TEST(concurrent_signal_testing, disconnect_in_emit)
+{
+    using connection = signals::concurrent_signal<void()>::connection;
+    signals::concurrent_signal<void()> sig;
+    uint32_t got1 = 0;
+    connection conn1 = sig.connect([&] { ++got1; });
+    uint32_t got2 = 0;
+    connection conn2;
+    conn2 = sig.connect([&] { ++got2; conn1.disconnect(); conn2.disconnect(); });
+
+    sig();
+    sig();
+
+    EXPECT_EQ(0, got1);
+    EXPECT_EQ(1, got2);
+}
+
+TEST(concurrent_signal_testing, disconnect_in_emit_while_other_thread_disconnects)
+{
+    using connection = signals::concurrent_signal<void()>::connection;
+    signals::concurrent_signal<void()> sig;
+    std::atomic<bool> entered{false};
+    connection other = sig.connect([] {});
+    connection self;
+    self = sig.connect([&]
+    {
+        entered.store(true);
+        // lets the other thread get to waiting for this emission
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        self.disconnect();
+    });
+
+    std::thread emitter([&] { sig(); });
+    while (!entered.load())
+        std::this_thread::yield();
+    other.disconnect();
+    emitter.join();
+
+    uint32_t got = 0;
+    auto conn = sig.connect([&] { ++got; });
+    sig();
+    EXPECT_EQ(1, got);
+}
+
+TEST(concurrent_signal_testing, destroy_signal_before_connection)
+{
+    auto sig = std::make_unique<signals::concurrent_signal<void()>>();
+    uint32_t got1 = 0;
+    auto conn1_old = sig->connect([&] { ++got1; });
+
+    sig.reset();
+
+    auto conn1_new = std::move(conn1_old);
+}
+
+TEST(concurrent_signal_testing, no_call_after_disconnect)
+{
+    using connection = signals::concurrent_signal<void()>::connection;
+    signals::concurrent_signal<void()> sig;
+    std::atomic<bool> stop{false};
+    std::atomic<uint32_t> late_calls{0};
+    std::atomic<uint64_t> calls{0};
+
+    std::vector<std::thread> emitters;
+    for (int i = 0; i < 3; i++)
+        emitters.emplace_back([&] { while (!stop.load()) sig(); });
+
+    for (int i = 0; i < 200; i++)
+    {
+        auto disconnected = std::make_unique<std::atomic<bool>>(false);
+        auto& flag = *disconnected;
+        connection conn = sig.connect([&calls, &late_calls, &flag]
+        {
+            if (flag.load())
+                ++late_calls;
+            ++calls;
+        });
+        std::this_thread::yield();
+        conn.disconnect();
+        flag.store(true);
+    }
+
+    stop.store(true);
+    for (auto& t : emitters)
+        t.join();
+
+    EXPECT_EQ(0, late_calls.load());
+}
+
+TEST(concurrent_signal_testing, emit_parallel)
+{
+    using connection = signals::concurrent_signal<void (int)>::connection;
+    signals::concurrent_signal<void (int)> sig;
+    signals::work_stealing_pool pool(3);
+    std::atomic<uint32_t> got{0};
+    std::vector<connection> conns;
+    for (int i = 0; i < 200; i++)
+        conns.push_back(sig.connect([&](int v) { got += v; }));
+
+    sig.emit_parallel(pool, 1);
+    sig.emit_parallel(pool, 2);
+
+    EXPECT_EQ(600, got.load());
+}
+
+TEST(concurrent_signal_testing, disconnect_in_emit_parallel)
+{
+    using connection = signals::concurrent_signal<void()>::connection;
+    signals::concurrent_signal<void()> sig;
+    signals::work_stealing_pool pool(2);
+    std::atomic<uint32_t> got{0};
+    std::vector<connection> conns(64);
+    for (auto& conn : conns)
+        conn = sig.connect([&got, &conn] { ++got; conn.disconnect(); });
+
+    sig.emit_parallel(pool);
+    sig.emit_parallel(pool);
+
+    EXPECT_EQ(64, got.load());
+}
+
+TEST(concurrent_signal_testing, disconnect_in_emit_parallel_while_other_thread_disconnects)
+{
+    using connection = signals::concurrent_signal<void()>::connection;
+    signals::concurrent_signal<void()> sig;
+    signals::work_stealing_pool pool(2);
+    std::atomic<bool> entered{false};
+    connection other = sig.connect([] {});
+    connection self;
+    self = sig.connect([&]
+    {
+        entered.store(true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        self.disconnect();
+    });
+
+    std::thread emitter([&] { sig.emit_parallel(pool); });
+    while (!entered.load())
+        std::this_thread::yield();
+    other.disconnect();
+    emitter.join();
+
+    std::atomic<uint32_t> got{0};
+    auto conn = sig.connect([&] { ++got; });
+    sig.emit_parallel(pool);
+    EXPECT_EQ(1, got.load());
+}
+
+TEST(concurrent_signal_testing, no_call_after_disconnect_parallel)
+{
+    using connection = signals::concurrent_signal<void()>::connection;
+    signals::concurrent_signal<void()> sig;
+    signals::work_stealing_pool pool(2);
+    std::atomic<bool> stop{false};
+    std::atomic<uint32_t> late_calls{0};
+    std::vector<connection> background;
+    for (int i = 0; i < 16; i++)
+        background.push_back(sig.connect([] {}));
+
+    std::thread emitter([&] { while (!stop.load()) sig.emit_parallel(pool); });
+
+    for (int i = 0; i < 200; i++)
+    {
+        auto disconnected = std::make_unique<std::atomic<bool>>(false);
+        auto& flag = *disconnected;
+        connection conn = sig.connect([&late_calls, &flag]
+        {
+            if (flag.load())
+                ++late_calls;
+        });
+        std::this_thread::yield();
+        conn.disconnect();
+        flag.store(true);
+    }
+
+    stop.store(true);
+    emitter.join();
+
+    EXPECT_EQ(0, late_calls.load());
+}
+
+TEST(signal_testing, emit_batch)
+{
+    signals::signal<void (int, int)> sig;
+    std::vector<int> got1;
+    auto conn1 = sig.connect([&](int a, int b) { got1.push_back(a * b); });
+    uint32_t got2 = 0;
+    auto conn2 = sig.connect([&](int a, int) { got2 += a; });
+
+    std::vector<std::tuple<int, int>> batch = {{1, 2}, {3, 4}, {5, 6}};
+    sig.emit_batch(batch);
+
+    EXPECT_EQ((std::vector<int>{2, 12, 30}), got1);
+    EXPECT_EQ(9, got2);
+}
+
+TEST(signal_testing, disconnect_in_emit_batch)
+{
+    using connection = signals::signal<void (int)>::connection;
+    signals::signal<void (int)> sig;
+    uint32_t got1 = 0;
+    connection conn1 = sig.connect([&](int) { ++got1; });
+    uint32_t got2 = 0;
+    connection conn2;
+    conn2 = sig.connect([&](int v) { ++got2; if (v == 2) conn2.disconnect(); });
+    uint32_t got3 = 0;
+    connection conn3 = sig.connect([&](int) { ++got3; });
+
+    std::tuple<int> batch[] = {{1}, {2}, {3}};
+    sig.emit_batch(batch);
+
+    EXPECT_EQ(3, got1);
+    EXPECT_EQ(2, got2);
+    EXPECT_EQ(3, got3);
+}
+
+TEST(signal_testing, destroy_signal_in_emit_batch)
+{
+    using connection = signals::signal<void (int)>::connection;
+
+    auto sig = std::make_unique<signals::signal<void (int)>>();
+    uint32_t got1 = 0;
+    connection conn1(sig->connect([&](int) { ++got1; }));
+    uint32_t got2 = 0;
+    connection conn2(sig->connect([&](int) { ++got2; sig.reset(); }));
+
+    std::tuple<int> batch[] = {{1}, {2}, {3}};
+    sig->emit_batch(batch);
+
+    EXPECT_EQ(1, got2);
+    EXPECT_EQ(0, got1);
+}
+
+TEST(signal_testing, no_argument_copies)
+{
+    struct counted
+    {
+        uint32_t* copies;
+        uint32_t* moves;
+        counted(uint32_t* copies, uint32_t* moves) : copies(copies), moves(moves) {}
+        counted(counted const& r) : copies(r.copies), moves(r.moves) { ++*copies; }
+        counted(counted&& r) noexcept : copies(r.copies), moves(r.moves) { ++*moves; }
+    };
+
+    uint32_t copies = 0;
+    uint32_t moves = 0;
+    signals::signal<void (counted)> sig;
+    auto conn1 = sig.connect([](counted const&) {});
+    auto conn2 = sig.connect([](counted const&) {});
+
+    sig(counted(&copies, &moves));
+    EXPECT_EQ(0, copies);
+    EXPECT_EQ(0, moves);
+
+    // slots run newest first, the first connected one is the last to run
+    signals::signal<void (counted)> sig_move;
+    auto conn3 = sig_move.connect([](counted) {});
+    auto conn4 = sig_move.connect([](counted) {});
+    sig_move.emit_move(counted(&copies, &moves));
+    EXPECT_EQ(1, copies);
+    EXPECT_EQ(1, moves);
+}
+
+namespace
+{
+    struct strict : signals::default_policy
+    {
+        static constexpr bool reject_copying_slots = true;
+    };
+}
+
+TEST(signal_testing, copying_slot_detection)
+{
+    static_assert(signals::copies_arguments_v<void (*)(std::string)>);
+    static_assert(!signals::copies_arguments_v<void (*)(std::string const&)>);
+    static_assert(!signals::copies_arguments_v<void (*)(int, double)>);
+
+    auto by_value = [](std::vector<char>) {};
+    auto by_ref = [](std::vector<char> const&) mutable {};
+    static_assert(signals::copies_arguments_v<decltype(by_value)>);
+    static_assert(!signals::copies_arguments_v<decltype(by_ref)>);
+
+    signals::signal<void (std::string), signals::default_inline_bytes, strict> sig;
+    uint32_t got = 0;
+    auto conn = sig.connect([&](std::string const& s) { got += s.size(); });
+    sig("abc");
+    EXPECT_EQ(3, got);
+}
+
+TEST(signal_testing, groups)
+{
+    signals::signal<void()> sig;
+    std::vector<int> order;
+    auto conn1 = sig.connect(2, [&] { order.push_back(21); });
+    auto conn2 = sig.connect(1, [&] { order.push_back(11); });
+    auto conn3 = sig.connect([&] { order.push_back(0); });
+    auto conn4 = sig.connect(2, [&] { order.push_back(22); });
+    auto conn5 = sig.connect(-1, [&] { order.push_back(-11); });
+
+    sig();
+    EXPECT_EQ((std::vector<int>{0, -11, 11, 22, 21}), order);
+
+    order.clear();
+    conn2.disconnect();
+    conn4.disconnect();
+    sig();
+    EXPECT_EQ((std::vector<int>{0, -11, 21}), order);
+}
+
+TEST(signal_testing, stop_emission)
+{
+    signals::signal<void()> sig;
+    uint32_t got1 = 0;
+    auto conn1 = sig.connect(1, [&] { ++got1; });
+    uint32_t got2 = 0;
+    auto conn2 = sig.connect(0, [&]
+    {
+        ++got2;
+        if (got2 == 1)
+        {
+            sig();
+            sig.stop_emission();
+        }
+    });
+
+    sig();
+    EXPECT_EQ(2, got2);
+    EXPECT_EQ(1, got1);
+}
+
+TEST(signal_testing, disconnect_in_emit_groups)
+{
+    using connection = signals::signal<void()>::connection;
+    signals::signal<void()> sig;
+    uint32_t got1 = 0;
+    connection conn1 = sig.connect(1, [&] { ++got1; });
+    uint32_t got2 = 0;
+    connection conn2;
+    conn2 = sig.connect(0, [&] { ++got2; conn2.disconnect(); });
+
+    sig();
+    sig();
+    EXPECT_EQ(1, got2);
+    EXPECT_EQ(2, got1);
+}
+
+namespace
+{
+    struct summing : signals::default_policy
+    {
+        template <typename R>
+        using combiner = signals::combiners::sum<R>;
+    };
+}
+
+TEST(signal_testing, result_last_value)
+{
+    signals::signal<int (int)> sig;
+    EXPECT_FALSE(sig(1).has_value());
+
+    auto conn1 = sig.connect([](int v) { return v * 10; });
+    auto conn2 = sig.connect([](int v) { return v; });
+
+    EXPECT_EQ(20, sig(2));
+}
+
+TEST(signal_testing, result_policy_combiner)
+{
+    signals::signal<int (int), signals::default_inline_bytes, summing> sig;
+    auto conn1 = sig.connect([](int v) { return v * 10; });
+    auto conn2 = sig.connect([](int v) { return v; });
+
+    EXPECT_EQ(22, sig(2));
+}
+
+TEST(signal_testing, result_combiners)
+{
+    signals::signal<int (int)> sig;
+    auto conn1 = sig.connect([](int v) { return v + 3; });
+    auto conn2 = sig.connect([](int v) { return v - 4; });
+    auto conn3 = sig.connect([](int v) { return v; });
+
+    EXPECT_EQ(2, sig.combine(signals::combiners::sum<int>(), 1));
+    EXPECT_EQ(-3, sig.combine(signals::combiners::minimum<int>(), 1));
+    EXPECT_EQ(4, sig.combine(signals::combiners::maximum<int>(), 1));
+
+    int buffer[2];
+    signals::combiners::collect_into<int> collect(buffer, 2);
+    EXPECT_EQ(2, sig.combine(collect, 1));
+    EXPECT_EQ(1, buffer[0]);
+    EXPECT_EQ(-3, buffer[1]);
+}
+
+TEST(signal_testing, result_short_circuit)
+{
+    signals::signal<bool ()> sig;
+    uint32_t got1 = 0;
+    auto conn1 = sig.connect([&] { ++got1; return true; });
+    uint32_t got2 = 0;
+    auto conn2 = sig.connect([&] { ++got2; return false; });
+
+    EXPECT_FALSE(sig.combine(signals::combiners::all_of<bool>()));
+    EXPECT_EQ(0, got1);
+    EXPECT_EQ(1, got2);
+
+    EXPECT_TRUE(sig.combine(signals::combiners::any_of<bool>()));
+    EXPECT_EQ(1, got1);
+    EXPECT_EQ(2, got2);
+
+    signals::signal<int const* ()> ptr_sig;
+    int value = 5;
+    auto conn3 = ptr_sig.connect([&] { return &value; });
+    auto conn4 = ptr_sig.connect([]() -> int const* { return nullptr; });
+    EXPECT_EQ(&value, ptr_sig.combine(signals::combiners::first_non_null<int const*>()));
+}
+
+TEST(signal_testing, result_disconnect_in_emit)
+{
+    using connection = signals::signal<int ()>::connection;
+    signals::signal<int ()> sig;
+    connection conn1 = sig.connect([] { return 1; });
+    connection conn2;
+    conn2 = sig.connect([&] { conn2.disconnect(); return 2; });
+
+    EXPECT_EQ(3, sig.combine(signals::combiners::sum<int>()));
+    EXPECT_EQ(1, sig.combine(signals::combiners::sum<int>()));
+}
+
+namespace
+{
+    struct manual_executor
+    {
+        std::vector<std::function<void ()>> tasks;
+
+        template <typename F>
+        void post(F&& f)
+        {
+            tasks.emplace_back(std::forward<F>(f));
+        }
+
+        void run()
+        {
+            auto current = std::move(tasks);
+            tasks.clear();
+            for (auto& t : current)
+                t();
+        }
+    };
+
+    struct thread_executor
+    {
+        std::mutex m;
+        std::condition_variable cv;
+        std::vector<std::function<void ()>> tasks;
+        bool done = false;
+
+        template <typename F>
+        void post(F&& f)
+        {
+            std::lock_guard<std::mutex> lock(m);
+            tasks.emplace_back(std::forward<F>(f));
+            cv.notify_one();
+        }
+
+        void work()
+        {
+            std::unique_lock<std::mutex> lock(m);
+            for (;;)
+            {
+                cv.wait(lock, [&] { return done || !tasks.empty(); });
+                if (tasks.empty())
+                    return;
+                auto current = std::move(tasks);
+                tasks.clear();
+                lock.unlock();
+                for (auto& t : current)
+                    t();
+                lock.lock();
+            }
+        }
+    };
+}
+
+TEST(queued_connection_testing, deliver_later)
+{
+    signals::signal<void (std::string const&, int)> sig;
+    manual_executor executor;
+    std::vector<std::string> got;
+    auto conn = signals::connect_queued(sig, executor, [&](std::string const& s, int n)
+    {
+        got.push_back(s + std::to_string(n));
+    });
+
+    sig(std::string("a"), 1);
+    sig(std::string("b"), 2);
+    EXPECT_TRUE(got.empty());
+
+    executor.run();
+    EXPECT_EQ((std::vector<std::string>{"a1", "b2"}), got);
+}
+
+TEST(queued_connection_testing, disconnect_cancels)
+{
+    signals::signal<void (int)> sig;
+    manual_executor executor;
+    uint32_t got = 0;
+    auto conn = signals::connect_queued(sig, executor, [&](int v) { got += v; });
+
+    sig(1);
+    executor.run();
+    sig(2);
+    conn.disconnect();
+    sig(4);
+
+    EXPECT_EQ(1, executor.tasks.size());
+    executor.run();
+    EXPECT_EQ(1, got);
+}
+
+TEST(queued_connection_testing, message_reuse)
+{
+    signals::signal<void (int)> sig;
+    manual_executor executor;
+    uint64_t got = 0;
+    auto conn = signals::connect_queued(sig, executor, [&](int v) { got += v; });
+
+    for (int round = 0; round < 4; round++)
+    {
+        for (int i = 0; i < 100; i++)
+            sig(i);
+        executor.run();
+    }
+    EXPECT_EQ(4 * 4950, got);
+}
+
+namespace
+{
+    struct copy_fails
+    {
+        bool fail;
+
+        explicit copy_fails(bool fail) noexcept
+        : fail(fail)
+        {}
+
+        copy_fails(copy_fails const& r)
+        : fail(r.fail)
+        {
+            if (fail)
+                throw std::runtime_error("copy");
+        }
+    };
+}
+
+TEST(queued_connection_testing, argument_copy_throws)
+{
+    signals::signal<void (copy_fails)> sig;
+    manual_executor executor;
+    uint32_t got = 0;
+    auto conn = signals::connect_queued(sig, executor, [&](copy_fails const&) { ++got; });
+
+    for (int i = 0; i < 100; i++)
+        EXPECT_THROW(sig(copy_fails(true)), std::runtime_error);
+    sig(copy_fails(false));
+    executor.run();
+    EXPECT_EQ(1, got);
+}
+
+TEST(queued_connection_testing, worker_thread)
+{
+    thread_executor executor;
+
+    std::thread worker([&] { executor.work(); });
+    signals::signal<void (int)> sig;
+    std::atomic<uint64_t> got{0};
+    {
+        auto conn = signals::connect_queued(sig, executor, [&](int v) { got += v; });
+        for (int i = 0; i < 1000; i++)
+            sig(1);
+        {
+            std::unique_lock<std::mutex> lock(executor.m);
+            executor.done = true;
+            executor.cv.notify_one();
+        }
+        worker.join();
+    }
+    EXPECT_EQ(1000, got.load());
+}
+
+namespace
+{
+    struct counted_policy : signals::default_policy
+    {
+        using instrumentation = signals::counting_instrumentation;
+    };
+}
+
+TEST(signal_testing, instrumentation)
+{
+    using signal_type = signals::signal<void(), signals::default_inline_bytes, counted_policy>;
+    static_assert(sizeof(signals::signal<void()>) < sizeof(signal_type));
+    static_assert(std::is_empty_v<signals::no_instrumentation>);
+
+    signal_type sig;
+    sig();
+
+    signal_type::connection conn1_old;
+    std::unique_ptr<signal_type::connection> conn1_new;
+    conn1_old = sig.connect([&] { if (!conn1_new) conn1_new = std::make_unique<signal_type::connection>(std::move(conn1_old)); });
+    signal_type::connection conn2;
+    conn2 = sig.connect([&] { conn2.disconnect(); });
+
+    sig();
+    sig();
+
+    auto stats = sig.instrumentation().snapshot();
+    EXPECT_EQ(3, stats.emits);
+    EXPECT_EQ(3, stats.slots);
+    EXPECT_EQ(1, stats.disconnects_in_emit);
+    EXPECT_EQ(1, stats.moves_in_emit);
+
+    uint64_t total = 0;
+    for (auto n : stats.slot_latency)
+        total += n;
+    EXPECT_EQ(3, total);
+    EXPECT_LE(stats.slot_latency_quantile(0.), stats.slot_latency_quantile(1.));
+}
+
+TEST(signal_testing, instrumentation_buckets)
+{
+    using counting = signals::counting_instrumentation;
+    for (uint64_t ns : {0ull, 7ull, 8ull, 15ull, 16ull, 17ull, 1000ull, 123456789ull, ~0ull})
+    {
+        auto i = counting::bucket_of(ns);
+        ASSERT_LT(i, counting::buckets);
+        EXPECT_LE(counting::bucket_lower_bound(i), ns);
+        if (i + 1 < counting::buckets)
+        {
+            EXPECT_GT(counting::bucket_lower_bound(i + 1), ns);
+        }
+    }
+}
+
+namespace
+{
+    struct traced_policy : signals::default_policy
+    {
+        using instrumentation = signals::tracing_instrumentation;
+    };
+}
+
+TEST(signal_testing, tracing)
+{
+    using signal_type = signals::signal<void(), signals::default_inline_bytes, traced_policy>;
+    using tracing = signals::tracing_instrumentation;
+    tracing::clear();
+
+    signal_type sig;
+    sig.instrumentation().name = "frame \"tick\"";
+    uint32_t got = 0;
+    auto conn = sig.connect([&]
+    {
+        if (++got == 1)
+            sig();
+    });
+    sig();
+
+    uint32_t emits = 0;
+    uint32_t slots = 0;
+    uint32_t max_depth = 0;
+    tracing::visit_events([&](uint32_t, tracing::event const& e)
+    {
+        if (e.signal != &sig.instrumentation())
+            return;
+        EXPECT_LE(e.begin_ns, e.end_ns);
+        ++(e.slot == nullptr ? emits : slots);
+        max_depth = std::max(max_depth, e.depth);
+    });
+    EXPECT_EQ(2, emits);
+    EXPECT_EQ(2, slots);
+    EXPECT_EQ(1, max_depth);
+
+    std::ostringstream out;
+    tracing::dump_chrome_trace(out);
+    auto json = out.str();
+    EXPECT_EQ(0, json.find("{\"traceEvents\":["));
+    EXPECT_NE(std::string::npos, json.find("\"name\":\"frame \\\"tick\\\"\""));
+    EXPECT_NE(std::string::npos, json.find("\"cat\":\"slot\""));
+}
+
+namespace
+{
+    struct unrolled_policy : signals::default_policy
+    {
+        using container = intrusive::unrolled;
+    };
+
+    using unrolled_signal = signals::signal<void (int), signals::default_inline_bytes, unrolled_policy>;
+}
+
+TEST(unrolled_signal_testing, order_and_groups)
+{
+    unrolled_signal sig;
+    std::vector<int> order;
+    std::vector<unrolled_signal::connection> conns;
+    for (int i = 0; i < 40; i++)
+        conns.push_back(sig.connect([&order, i](int) { order.push_back(i); }));
+    auto grouped = sig.connect(1, [&](int) { order.push_back(-1); });
+    auto first_group = sig.connect(0, [&](int) { order.push_back(-2); });
+
+    sig(0);
+    std::vector<int> expected;
+    for (int i = 39; i >= 0; i--)
+        expected.push_back(i);
+    expected.push_back(-2);
+    expected.push_back(-1);
+    EXPECT_EQ(expected, order);
+}
+
+TEST(unrolled_signal_testing, disconnect_and_move_in_emit)
+{
+    using connection = unrolled_signal::connection;
+    unrolled_signal sig;
+    uint32_t got1 = 0;
+    connection conn1 = sig.connect([&](int) { ++got1; });
+    uint32_t got2 = 0;
+    connection conn2;
+    conn2 = sig.connect([&](int) { ++got2; conn2.disconnect(); conn1.disconnect(); });
+    uint32_t got3 = 0;
+    connection conn3_old;
+    std::unique_ptr<connection> conn3_new;
+    conn3_old = sig.connect([&](int)
+    {
+        if (++got3 == 1)
+            conn3_new = std::make_unique<connection>(std::move(conn3_old));
+    });
+
+    sig(0);
+    sig(0);
+
+    EXPECT_EQ(0, got1);
+    EXPECT_EQ(1, got2);
+    EXPECT_EQ(2, got3);
+}
+
+TEST(unrolled_signal_testing, connect_in_emit)
+{
+    using connection = unrolled_signal::connection;
+    unrolled_signal sig;
+    std::vector<connection> added;
+    added.reserve(100);
+    uint32_t got = 0;
+    std::vector<connection> conns;
+    for (int i = 0; i < 20; i++)
+    {
+        conns.push_back(sig.connect([&](int v)
+        {
+            ++got;
+            if (v == 1)
+                for (int j = 0; j < 5; j++)
+                    added.push_back(sig.connect(j, [&](int) { ++got; }));
+        }));
+    }
+
+    // the grouped slots connected by the first emission run in it as well
+    sig(1);
+    EXPECT_EQ(120, got);
+    got = 0;
+    sig(0);
+    EXPECT_EQ(120, got);
+}
+
+TEST(unrolled_signal_testing, destroy_signal_before_connection)
+{
+    auto sig = std::make_unique<unrolled_signal>();
+    uint32_t got = 0;
+    auto conn1 = sig->connect([&](int) { ++got; });
+    auto conn2 = sig->connect([&](int) { ++got; sig.reset(); });
+
+    (*sig)(0);
+    EXPECT_EQ(1, got);
+    auto conn3 = std::move(conn1);
+}
+
+TEST(unrolled_signal_testing, matches_linked)
+{
+    signals::signal<void (int)> linked;
+    unrolled_signal unrolled;
+    std::vector<int> got_linked;
+    std::vector<int> got_unrolled;
+    std::vector<signals::signal<void (int)>::connection> linked_conns;
+    std::vector<unrolled_signal::connection> unrolled_conns;
+
+    uint32_t state = 12345;
+    auto next = [&] { state = state * 1103515245 + 12345; return state >> 8; };
+    for (int step = 0; step < 2000; step++)
+    {
+        auto what = next() % 8;
+        if (what < 4 || linked_conns.empty())
+        {
+            int group = int(next() % 4) - 1;
+            if (group < 0)
+            {
+                linked_conns.push_back(linked.connect([&got_linked, step](int) { got_linked.push_back(step); }));
+                unrolled_conns.push_back(unrolled.connect([&got_unrolled, step](int) { got_unrolled.push_back(step); }));
+            }
+            else
+            {
+                linked_conns.push_back(linked.connect(group, [&got_linked, step](int) { got_linked.push_back(step); }));
+                unrolled_conns.push_back(unrolled.connect(group, [&got_unrolled, step](int) { got_unrolled.push_back(step); }));
+            }
+        }
+        else if (what < 7)
+        {
+            auto i = next() % linked_conns.size();
+            linked_conns.erase(linked_conns.begin() + i);
+            unrolled_conns.erase(unrolled_conns.begin() + i);
+        }
+        else
+        {
+            linked(step);
+            unrolled(step);
+        }
+    }
+    linked(0);
+    unrolled(0);
+
+    EXPECT_EQ(got_linked, got_unrolled);
+}
+
+namespace
+{
+    struct noexcept_policy : signals::default_policy
+    {
+        using exception_handling = signals::exceptions::require_noexcept;
+    };
+
+    std::vector<std::string> reported;
+
+    struct collect_errors
+    {
+        void operator()(std::exception_ptr e) const noexcept
+        {
+            try
+            {
+                std::rethrow_exception(e);
+            }
+            catch (std::exception const& ex)
+            {
+                reported.push_back(ex.what());
+            }
+        }
+    };
+
+    struct reporting_policy : signals::default_policy
+    {
+        using exception_handling = signals::exceptions::report<collect_errors>;
+    };
+}
+
+TEST(signal_testing, noexcept_slots)
+{
+    using signal_type = signals::signal<void (int), signals::default_inline_bytes, noexcept_policy>;
+    signal_type sig;
+    uint32_t got = 0;
+    auto conn = sig.connect([&](int v) noexcept { got += v; });
+
+    static_assert(noexcept(sig(1)));
+    static_assert(!noexcept(std::declval<signals::signal<void (int)>&>()(1)));
+    static_assert(std::is_constructible_v<signal_type::slot_type, void (*)(int) noexcept>);
+    static_assert(!std::is_constructible_v<signal_type::slot_type, void (*)(int)>);
+
+    sig(2);
+    EXPECT_EQ(2, got);
+}
+
+TEST(signal_testing, reported_exceptions)
+{
+    using signal_type = signals::signal<void (int), signals::default_inline_bytes, reporting_policy>;
+    reported.clear();
+    signal_type sig;
+    uint32_t got1 = 0;
+    auto conn1 = sig.connect([&](int) { ++got1; });
+    auto conn2 = sig.connect([&](int v) { if (v == 1) throw std::runtime_error("first"); });
+    uint32_t got3 = 0;
+    auto conn3 = sig.connect([&](int) { ++got3; throw std::runtime_error("third"); });
+
+    static_assert(noexcept(sig(1)));
+    sig(1);
+    sig(2);
+
+    EXPECT_EQ(2, got1);
+    EXPECT_EQ(2, got3);
+    EXPECT_EQ((std::vector<std::string>{"third", "first", "third"}), reported);
+}
+
+namespace
+{
+
+struct tracked_object : signals::trackable
+{
+    uint32_t got = 0;
+};
+
+}
+
+TEST(signal_testing, tracked_object_destroyed)
+{
+    signals::signal<void()> sig;
+    auto obj = std::make_unique<tracked_object>();
+    sig.connect_tracked(*obj, [o = obj.get()] { ++o->got; });
+    uint32_t got = 0;
+    auto conn = sig.connect([&] { ++got; });
+
+    sig();
+    EXPECT_EQ(1, obj->got);
+
+    obj.reset();
+    sig();
+    EXPECT_EQ(2, got);
+}
+
+TEST(signal_testing, tracked_object_destroyed_in_emit)
+{
+    signals::signal<void()> sig;
+    auto obj = std::make_unique<tracked_object>();
+    uint32_t got1 = 0;
+    auto conn1 = sig.connect([&] { ++got1; });
+    sig.connect_tracked(*obj, [o = obj.get()] { ++o->got; });
+    sig.connect_tracked(*obj, [&] { obj.reset(); });
+    uint32_t got3 = 0;
+    auto conn3 = sig.connect([&] { ++got3; });
+
+    sig();
+    EXPECT_EQ(nullptr, obj);
+    EXPECT_EQ(1, got1);
+    EXPECT_EQ(1, got3);
+
+    sig();
+    EXPECT_EQ(2, got1);
+    EXPECT_EQ(2, got3);
+}
+
+TEST(signal_testing, tracked_object_outlives_signal)
+{
+    tracked_object obj;
+    auto sig = std::make_unique<signals::signal<void()>>();
+    sig->connect_tracked(obj, [&] { ++obj.got; });
+    (*sig)();
+    sig.reset();
+    EXPECT_EQ(1, obj.got);
+}
+
+TEST(signal_testing, tracked_object_in_many_signals)
+{
+    signals::signal<void()> sig1;
+    signals::signal<void(int)> sig2;
+    tracked_object copied;
+    {
+        tracked_object obj;
+        sig1.connect_tracked(obj, [&] { ++copied.got; });
+        sig2.connect_tracked(obj, [&](int v) { copied.got += v; });
+        sig2.connect_tracked(obj, [&](int v) { copied.got += v; });
+        copied = obj;
+
+        sig1();
+        sig2(10);
+        EXPECT_EQ(21, copied.got);
+    }
+    sig1();
+    sig2(10);
+    EXPECT_EQ(21, copied.got);
+}
+
+TEST(signal_testing, keyed_connection)
+{
+    signals::signal<void(int)> sig;
+    int a = 0;
+    int b = 0;
+
+    EXPECT_TRUE(sig.connect(&a, [&](int v) { a += v; }));
+    EXPECT_FALSE(sig.connect(&a, [&](int v) { a += 100 * v; }));
+    EXPECT_TRUE(sig.connect(&b, [&](int v) { b += v; }));
+    EXPECT_TRUE(sig.connected(&a));
+
+    sig(1);
+    EXPECT_EQ(1, a);
+    EXPECT_EQ(1, b);
+
+    EXPECT_TRUE(sig.disconnect(&a));
+    EXPECT_FALSE(sig.disconnect(&a));
+    EXPECT_FALSE(sig.connected(&a));
+    sig(1);
+    EXPECT_EQ(1, a);
+    EXPECT_EQ(2, b);
+
+    EXPECT_TRUE(sig.connect(&a, [&](int v) { a += 10 * v; }));
+    sig(1);
+    EXPECT_EQ(11, a);
+    EXPECT_EQ(3, b);
+}
+
+TEST(signal_testing, keyed_disconnect_in_emit)
+{
+    signals::signal<void()> sig;
+    int keys[3] = {};
+    uint32_t got1 = 0;
+    sig.connect(&keys[0], [&] { ++got1; });
+    uint32_t got2 = 0;
+    sig.connect(&keys[1], [&] { ++got2; sig.disconnect(&keys[1]); sig.disconnect(&keys[0]); });
+    uint32_t got3 = 0;
+    sig.connect(&keys[2], [&] { ++got3; });
+
+    sig();
+    sig();
+
+    EXPECT_EQ(0, got1);
+    EXPECT_EQ(1, got2);
+    EXPECT_EQ(2, got3);
+    EXPECT_TRUE(sig.connected(&keys[2]));
+}
+
+TEST(signal_testing, keyed_many)
+{
+    signals::signal<void()> sig;
+    std::vector<int> keys(1000);
+    std::vector<uint32_t> got(keys.size());
+    for (std::size_t i = 0; i < keys.size(); i++)
+        EXPECT_TRUE(sig.connect(&keys[i], [&got, i] { ++got[i]; }));
+    for (std::size_t i = 0; i < keys.size(); i += 3)
+        EXPECT_TRUE(sig.disconnect(&keys[i]));
+
+    sig();
+
+    for (std::size_t i = 0; i < keys.size(); i++)
+    {
+        EXPECT_EQ(i % 3 != 0, sig.connected(&keys[i]));
+        EXPECT_EQ(i % 3 != 0 ? 1u : 0u, got[i]);
+    }
+}
+
+TEST(signal_testing, keyed_destroy_signal_in_emit)
+{
+    auto sig = std::make_unique<signals::signal<void()>>();
+    int key = 0;
+    uint32_t got = 0;
+    sig->connect(&key, [&] { ++got; });
+    sig->connect(&got, [&] { ++got; sig.reset(); });
+
+    (*sig)();
+    EXPECT_EQ(1, got);
+}
+
+TEST(coalescing_signal_testing, last_value)
+{
+    signals::coalescing_signal<void(int, std::string const&)> sig;
+    std::vector<std::pair<int, std::string>> got;
+    auto conn = sig.connect([&](int id, std::string const& v) { got.emplace_back(id, v); });
+
+    for (int i = 0; i < 100; i++)
+    {
+        sig(7, "a" + std::to_string(i));
+        sig(3, "b" + std::to_string(i));
+    }
+    EXPECT_TRUE(got.empty());
+    EXPECT_EQ(2, sig.pending_count());
+
+    EXPECT_EQ(2, sig.flush());
+    EXPECT_EQ((std::vector<std::pair<int, std::string>>{{7, "a99"}, {3, "b99"}}), got);
+
+    EXPECT_EQ(0, sig.flush());
+    EXPECT_EQ(2, got.size());
+}
+
+TEST(coalescing_signal_testing, merge)
+{
+    auto add = [](int& pending, int delta) { pending += delta; };
+    signals::coalescing_signal<void(std::string, int), decltype(add)> sig(add);
+    std::vector<std::pair<std::string, int>> got;
+    auto conn = sig.connect([&](std::string const& id, int v) { got.emplace_back(id, v); });
+
+    sig("y", 1);
+    sig("x", 2);
+    sig("y", 3);
+    sig("x", 4);
+    sig("z", 5);
+    sig.flush();
+
+    EXPECT_EQ((std::vector<std::pair<std::string, int>>{{"y", 4}, {"x", 6}, {"z", 5}}), got);
+}
+
+TEST(coalescing_signal_testing, keys_only)
+{
+    signals::coalescing_signal<void(std::size_t), signals::coalesce::last_value, signals::coalesce::dense_keys<1024>> sig;
+    std::vector<std::size_t> got;
+    auto conn = sig.connect([&](std::size_t id) { got.push_back(id); });
+
+    for (int round = 0; round < 10; round++)
+        for (std::size_t id : {1000u, 5u, 64u, 63u, 5u})
+            sig(id);
+    sig.flush();
+
+    EXPECT_EQ((std::vector<std::size_t>{5, 63, 64, 1000}), got);
+}
+
+TEST(coalescing_signal_testing, sparse_keys)
+{
+    std::vector<std::pair<std::uint64_t, int>> got;
+    auto record = [&](std::uint64_t id, int v) { got.emplace_back(id, v); };
+    signals::coalescing_signal<void(std::uint64_t, int)> hashed;
+    auto conn1 = hashed.connect(record);
+    hashed(1ull << 40, 1);
+    hashed(3, 2);
+    hashed(1ull << 40, 3);
+    EXPECT_EQ(2, hashed.flush());
+    EXPECT_EQ((std::vector<std::pair<std::uint64_t, int>>{{1ull << 40, 3}, {3, 2}}), got);
+
+    // keys outside of the dense range are flushed after the dense ones, negative ones too
+    got.clear();
+    signals::coalescing_signal<void(long long, int), signals::coalesce::last_value, signals::coalesce::dense_keys<64>> dense;
+    auto conn2 = dense.connect([&](long long id, int v) { got.emplace_back(std::uint64_t(id), v); });
+    dense(1ll << 40, 1);
+    dense(-1, 2);
+    dense(63, 3);
+    dense(64, 4);
+    dense(5, 5);
+    dense(-1, 6);
+    EXPECT_EQ(5, dense.pending_count());
+    EXPECT_EQ(5, dense.flush());
+    EXPECT_EQ((std::vector<std::pair<std::uint64_t, int>>{{5, 5}, {63, 3}, {1ull << 40, 1}, {std::uint64_t(-1), 6}, {64, 4}}), got);
+}
+
+TEST(coalescing_signal_testing, emit_while_flushing)
+{
+    signals::coalescing_signal<void(int, int)> sig;
+    uint32_t wakeups = 0;
+    sig.on_pending([&] { ++wakeups; });
+    std::vector<std::pair<int, int>> got;
+    auto conn = sig.connect([&](int id, int v)
+    {
+        got.emplace_back(id, v);
+        if (v < 2)
+            sig(id, v + 1);
+    });
+
+    sig(1, 0);
+    sig(2, 0);
+    EXPECT_EQ(1, wakeups);
+
+    EXPECT_EQ(2, sig.flush());
+    EXPECT_EQ(2, wakeups);
+    EXPECT_EQ(2, sig.pending_count());
+    sig.flush();
+    sig.flush();
+    EXPECT_EQ(0, sig.flush());
+    EXPECT_EQ(3, wakeups);
+    EXPECT_EQ((std::vector<std::pair<int, int>>{{1, 0}, {2, 0}, {1, 1}, {2, 1}, {1, 2}, {2, 2}}), got);
+}
+
+namespace
+{
+    struct compact_policy : signals::default_policy
+    {
+        static constexpr bool compact_connections = true;
+    };
+
+    using compact_signal = signals::signal<void (int), sizeof(void*), compact_policy>;
+
+    static_assert(sizeof(signals::signal<void ()>::connection) == 10 * sizeof(void*));
+    static_assert(sizeof(compact_signal::connection) == 5 * sizeof(void*));
+    static_assert(sizeof(signals::signal<void (int), sizeof(void*), unrolled_policy>::connection) == 6 * sizeof(void*));
+}
+
+TEST(compact_signal_testing, disconnect_and_move_in_emit)
+{
+    using connection = compact_signal::connection;
+    compact_signal sig;
+    uint32_t got1 = 0;
+    connection conn1 = sig.connect([&](int) { ++got1; });
+    uint32_t got2 = 0;
+    connection conn2;
+    conn2 = sig.connect([&](int) { ++got2; conn2.disconnect(); conn1.disconnect(); });
+    uint32_t got3 = 0;
+    connection conn3_old;
+    std::unique_ptr<connection> conn3_new;
+    conn3_old = sig.connect([&](int)
+    {
+        if (++got3 == 1)
+            conn3_new = std::make_unique<connection>(std::move(conn3_old));
+    });
+
+    sig(0);
+    sig(0);
+
+    EXPECT_EQ(0, got1);
+    EXPECT_EQ(1, got2);
+    EXPECT_EQ(2, got3);
+}
+
+TEST(compact_signal_testing, nested_signals)
+{
+    using connection = compact_signal::connection;
+    compact_signal outer;
+    compact_signal inner;
+    std::vector<int> order;
+    connection inner1 = inner.connect([&](int) { order.push_back(11); });
+    connection inner2 = inner.connect([&](int) { order.push_back(12); inner1.disconnect(); outer.stop_emission(); });
+    connection outer1 = outer.connect([&](int) { order.push_back(1); });
+    connection outer2 = outer.connect([&](int) { order.push_back(2); inner(0); inner.stop_emission(); });
+
+    outer(0);
+    outer(0);
+    inner(0);
+
+    EXPECT_EQ((std::vector<int>{2, 12, 2, 12, 12}), order);
+}
+
+TEST(compact_signal_testing, destroy_signal_in_nested_emit)
+{
+    compact_signal outer;
+    auto inner = std::make_unique<compact_signal>();
+    uint32_t got = 0;
+    auto inner1 = inner->connect([&](int) { ++got; });
+    auto inner2 = inner->connect([&](int) { inner.reset(); });
+    auto outer1 = outer.connect([&](int) { ++got; });
+    auto outer2 = outer.connect([&](int) { (*inner)(0); });
+
+    outer(0);
+    EXPECT_EQ(nullptr, inner);
+    EXPECT_EQ(1, got);
+    auto moved = std::move(inner1);
+}
+
+TEST(compact_signal_testing, connection_group)
+{
+    compact_signal sig;
+    uint32_t got = 0;
+    compact_signal::connection_group group;
+    for (int i = 0; i < 3; i++)
+        group.connect(sig, [&](int) { ++got; });
+    group.connect(sig, [&](int v) { if (v == 1) group.disconnect(); });
+
+    sig(1);
+    EXPECT_EQ(0, got);
+    sig(1);
+    EXPECT_EQ(0, got);
+}
+
+TEST(signal_testing, lone_slot)
+{
+    auto sig = std::make_unique<signals::signal<void(int)>>();
+    std::vector<int> got;
+    signals::signal<void(int)>::connection conn;
+    conn = sig->connect([&](int v)
+    {
+        got.push_back(v);
+        if (v == 1)
+            (*sig)(2);
+        else if (v == 3)
+            conn.disconnect();
+        else if (v == 5)
+            sig.reset();
+    });
+
+    (*sig)(1);
+    (*sig)(3);
+    (*sig)(4);
+    EXPECT_EQ((std::vector<int>{1, 2, 3}), got);
+
+    conn = sig->connect([&](int v) { got.push_back(v); sig->stop_emission(); if (v == 5) sig.reset(); });
+    (*sig)(5);
+    EXPECT_EQ(nullptr, sig);
+    EXPECT_EQ((std::vector<int>{1, 2, 3, 5}), got);
+}
+
+TEST(signal_testing, lone_slot_connects)
+{
+    signals::signal<void()> sig;
+    std::vector<int> order;
+    std::vector<signals::signal<void()>::connection> conns;
+    conns.reserve(4);
+    conns.push_back(sig.connect([&]
+    {
+        order.push_back(0);
+        if (conns.size() == 1)
+        {
+            conns.push_back(sig.connect([&] { order.push_back(1); }));
+            conns.push_back(sig.connect(0, [&] { order.push_back(2); }));
+        }
+    }));
+
+    sig();
+    EXPECT_EQ((std::vector<int>{0}), order);
+    sig();
+    EXPECT_EQ((std::vector<int>{0, 1, 0, 2}), order);
+}
+
+TEST(signal_testing, lone_slot_reported_exception)
+{
+    using signal_type = signals::signal<void (int), signals::default_inline_bytes, reporting_policy>;
+    reported.clear();
+    signal_type sig;
+    auto conn = sig.connect([&](int) { throw std::runtime_error("lone"); });
+
+    sig(1);
+    EXPECT_EQ((std::vector<std::string>{"lone"}), reported);
+}
+
+namespace
+{
+    struct deferred_policy : signals::default_policy
+    {
+        static constexpr bool deferred_disconnect = true;
+    };
+
+    using deferred_signal = signals::signal<void (), signals::default_inline_bytes, deferred_policy>;
+}
+
+TEST(deferred_signal_testing, pooled_disconnect_in_nested_emit)
+{
+    deferred_signal sig;
+    std::vector<int> order;
+    bool nested = false;
+    deferred_signal::pooled_connection p1, p2, p3;
+    p1 = sig.connect_pooled([&] { order.push_back(1); });
+    p2 = sig.connect_pooled([&]
+    {
+        order.push_back(2);
+        if (nested)
+        {
+            p1.disconnect();
+            p2.disconnect();
+        }
+    });
+    p3 = sig.connect_pooled([&]
+    {
+        order.push_back(3);
+        if (nested)
+            return;
+        nested = true;
+        sig();
+        nested = false;
+    });
+
+    sig();
+    sig();
+    EXPECT_EQ((std::vector<int>{3, 3, 2, 3, 3}), order);
+}
+
+TEST(deferred_signal_testing, tracked_object_destroyed_in_emit)
+{
+    deferred_signal sig;
+    auto obj = std::make_unique<tracked_object>();
+    uint32_t got = 0;
+    for (int i = 0; i < 10; i++)
+        sig.connect_tracked(*obj, [&] { ++got; });
+    bool nested = false;
+    auto conn = sig.connect([&]
+    {
+        if (nested)
+            return;
+        nested = true;
+        sig();
+        obj.reset();
+    });
+
+    sig();
+    EXPECT_EQ(nullptr, obj);
+    EXPECT_EQ(10, got);
+    sig();
+    EXPECT_EQ(10, got);
+}
+
+TEST(deferred_signal_testing, keyed_reconnect_in_emit)
+{
+    deferred_signal sig;
+    int key = 0;
+    std::vector<int> order;
+    EXPECT_TRUE(sig.connect(&key, [&] { order.push_back(1); }));
+    auto conn = sig.connect([&]
+    {
+        order.push_back(0);
+        if (order.size() != 1)
+            return;
+        EXPECT_TRUE(sig.disconnect(&key));
+        EXPECT_TRUE(sig.connect(&key, [&] { order.push_back(2); }));
+    });
+
+    sig();
+    sig();
+    EXPECT_TRUE(sig.connected(&key));
+    EXPECT_EQ((std::vector<int>{0, 2, 0}), order);
+}
+
+TEST(deferred_signal_testing, destroy_signal_with_parked)
+{
+    auto sig = std::make_unique<deferred_signal>();
+    uint32_t got = 0;
+    auto p1 = sig->connect_pooled([&] { ++got; });
+    deferred_signal::pooled_connection p2;
+    p2 = sig->connect_pooled([&] { p1.disconnect(); sig.reset(); });
+
+    (*sig)();
+    EXPECT_EQ(nullptr, sig);
+    EXPECT_EQ(0, got);
+}
+
+TEST(deferred_signal_testing, batch_stops_at_disconnect)
+{
+    using signal_type = signals::signal<void (int), signals::default_inline_bytes, deferred_policy>;
+    signal_type sig;
+    std::vector<int> got;
+    signal_type::pooled_connection conn;
+    conn = sig.connect_pooled([&](int v)
+    {
+        got.push_back(v);
+        if (v == 2)
+            conn.disconnect();
+    });
+
+    sig.emit_batch(std::vector<std::tuple<int>>{{1}, {2}, {3}});
+    EXPECT_EQ((std::vector<int>{1, 2}), got);
+}
+
+TEST(signal_testing, block_keeps_order)
+{
+    signals::signal<void()> sig;
+    std::vector<int> order;
+    auto conn1 = sig.connect([&] { order.push_back(1); });
+    auto conn2 = sig.connect(0, [&] { order.push_back(2); });
+    auto conn3 = sig.connect([&] { order.push_back(3); });
+
+    conn3.block();
+    EXPECT_TRUE(conn3.blocked());
+    sig();
+    auto moved = std::move(conn3);
+    EXPECT_TRUE(moved.blocked());
+    sig();
+    moved.unblock();
+    sig();
+
+    EXPECT_EQ((std::vector<int>{1, 2, 1, 2, 3, 1, 2}), order);
+}
+
+TEST(signal_testing, block_in_emit)
+{
+    using signal_type = signals::signal<void (std::string)>;
+    signal_type sig;
+    std::vector<std::string> got;
+    signal_type::connection conn1, conn2, conn3;
+    conn1 = sig.connect([&](std::string s) { got.push_back("1" + s); });
+    conn2 = sig.connect([&](std::string s) { got.push_back("2" + s); });
+    conn3 = sig.connect([&](std::string const& s) { got.push_back("3" + s); conn1.block(); });
+
+    // the last slot that is not blocked gets the argument moved in
+    std::string arg = "a";
+    sig.emit_move(std::move(arg));
+    sig("b");
+    EXPECT_EQ((std::vector<std::string>{"3a", "2a", "3b", "2b"}), got);
+    EXPECT_EQ("", arg);
+}
+
+TEST(signal_testing, shared_connection_block)
+{
+    signals::signal<void()> sig;
+    uint32_t got1 = 0;
+    auto conn1 = sig.connect([&] { ++got1; });
+    uint32_t got2 = 0;
+    auto conn2 = sig.connect_pooled([&] { ++got2; });
+    {
+        signals::shared_connection_block outer(conn1);
+        signals::shared_connection_block pooled(conn2);
+        {
+            signals::shared_connection_block inner(conn1);
+            sig();
+        }
+        EXPECT_TRUE(conn1.blocked());
+        pooled.unblock();
+        sig();
+    }
+    EXPECT_FALSE(conn1.blocked());
+    sig();
+
+    EXPECT_EQ(1, got1);
+    EXPECT_EQ(2, got2);
+}
+
+TEST(signal_testing, block_all)
+{
+    signals::signal<int()> sig;
+    auto conn = sig.connect([] { return 1; });
+    signals::signal<void()> lone;
+    uint32_t got = 0;
+    auto lone_conn = lone.connect([&] { ++got; lone.block_all(); });
+
+    sig.block_all();
+    EXPECT_TRUE(sig.all_blocked());
+    EXPECT_FALSE(sig());
+    sig.unblock_all();
+    EXPECT_EQ(1, sig());
+
+    lone();
+    lone();
+    EXPECT_EQ(1, got);
+    lone.unblock_all();
+    lone();
+    EXPECT_EQ(2, got);
+}
+
+#if defined(__linux__)
+namespace
+{
+    struct shm_event
+    {
+        std::uint64_t id;
+        double value;
+    };
+
+    std::string shm_name(char const* test)
+    {
+        return std::string("/signals_testing_") + test + "_" + std::to_string(::getpid());
+    }
+}
+
+TEST(shm_signal_testing, in_process)
+{
+    auto name = shm_name("in_process");
+    signals::shm_signal<void(shm_event const&, int)> sig(name, 16);
+    uint32_t local = 0;
+    auto local_conn = sig.connect([&](shm_event const&, int) { ++local; });
+    signals::shm_subscriber<void(shm_event const&, int)> sub(name);
+    std::vector<std::pair<std::uint64_t, int>> got;
+    auto conn = sub.connect([&](shm_event const& e, int tag) { got.emplace_back(e.id, tag); EXPECT_EQ(e.id * 0.5, e.value); });
+
+    EXPECT_EQ(0, sub.dispatch());
+    for (std::uint64_t i = 0; i < 10; i++)
+        sig(shm_event{i, i * 0.5}, int(i) * 10);
+    EXPECT_EQ(10, local);
+    EXPECT_TRUE(got.empty());
+
+    EXPECT_EQ(10, sub.dispatch());
+    ASSERT_EQ(10, got.size());
+    EXPECT_EQ(std::make_pair(std::uint64_t(9), 90), got.back());
+    EXPECT_EQ(0, sub.lost());
+
+    EXPECT_THROW((signals::shm_subscriber<void(int)>(name)), std::runtime_error);
+    EXPECT_THROW((signals::shm_subscriber<void(shm_event const&, int)>(name + "_missing")), std::system_error);
+}
+
+TEST(shm_signal_testing, overrun)
+{
+    auto name = shm_name("overrun");
+    signals::shm_signal<void(int)> sig(name, 5);
+    signals::shm_subscriber<void(int)> sub(name);
+    std::vector<int> got;
+    auto conn = sub.connect([&](int v) { got.push_back(v); });
+
+    for (int i = 0; i < 20; i++)
+        sig(i);
+    EXPECT_EQ(8, sub.dispatch());
+    EXPECT_EQ(12, sub.lost());
+    EXPECT_EQ((std::vector<int>{12, 13, 14, 15, 16, 17, 18, 19}), got);
+}
+
+TEST(shm_signal_testing, wake_sleeping_reader)
+{
+    auto name = shm_name("wake");
+    signals::shm_signal<void(int)> sig(name, 128);
+    signals::shm_subscriber<void(int)> sub(name);
+    int sum = 0;
+    auto conn = sub.connect([&](int v) { sum += v; });
+
+    std::thread reader([&]
+    {
+        while (sum + sub.lost() < 100)
+            sub.wait(std::chrono::seconds(5));
+    });
+    for (int i = 0; i < 100; i++)
+    {
+        sig(1);
+        if (i % 10 == 0)
+            std::this_thread::yield();
+    }
+    reader.join();
+    EXPECT_EQ(100, sum);
+    EXPECT_EQ(0, sub.lost());
+}
+
+TEST(shm_signal_testing, other_process)
+{
+    auto name = shm_name("fork");
+    signals::shm_signal<void(shm_event const&)> sig(name, 4096);
+    int ready[2];
+    ASSERT_EQ(0, ::pipe(ready));
+
+    pid_t child = ::fork();
+    ASSERT_GE(child, 0);
+    if (child == 0)
+    {
+        signals::shm_subscriber<void(shm_event const&)> sub(name);
+        std::uint64_t count = 0;
+        bool ordered = true;
+        auto conn = sub.connect([&](shm_event const& e) { ordered = ordered && e.id == count; ++count; });
+        char c = 1;
+        if (::write(ready[1], &c, 1) != 1)
+            ::_exit(3);
+        while (count < 1000)
+            if (sub.wait(std::chrono::seconds(5)) == 0)
+                ::_exit(2);
+        ::_exit(ordered && sub.lost() == 0 ? 0 : 1);
+    }
+
+    char c;
+    ASSERT_EQ(1, ::read(ready[0], &c, 1));
+    for (std::uint64_t i = 0; i < 1000; i++)
+        sig(shm_event{i, 0});
+    int status = 0;
+    ASSERT_EQ(child, ::waitpid(child, &status, 0));
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(0, WEXITSTATUS(status));
+    ::close(ready[0]);
+    ::close(ready[1]);
+}
+
+namespace
+{
+    // four shards on the cpus the test may run on, most of them run by their worker
+    std::vector<std::vector<unsigned>> four_shards()
+    {
+        auto cpus = signals::detail::allowed_cpus();
+        std::vector<std::vector<unsigned>> shards(4);
+        for (std::size_t i = 0; i < shards.size(); i++)
+            shards[i].push_back(cpus[i % cpus.size()]);
+        return shards;
+    }
+}
+
+TEST(sharded_signal_testing, every_shard)
+{
+    signals::sharded_signal<void (int)> sig(four_shards());
+    ASSERT_EQ(4, sig.shard_count());
+    std::array<std::atomic<int>, 8> got{};
+    std::array<std::thread::id, 8> ran_on;
+    std::vector<signals::sharded_signal<void (int)>::connection> conns;
+    for (std::size_t i = 0; i < got.size(); i++)
+        conns.push_back(sig.connect(i % 4, [&, i](int v)
+        {
+            got[i] += v;
+            ran_on[i] = std::this_thread::get_id();
+        }));
+    EXPECT_EQ(3, conns[3].shard_index());
+
+    sig(1);
+    sig(2);
+
+    // the emission returns once every shard is done
+    for (std::size_t i = 0; i < got.size(); i++)
+    {
+        EXPECT_EQ(3, got[i]);
+        EXPECT_EQ(ran_on[i % 4], ran_on[i]);
+    }
+    auto local = sig.local_shard();
+    for (std::size_t i = 0; i < 4; i++)
+        EXPECT_EQ(i == local, ran_on[i] == std::this_thread::get_id());
+}
+
+TEST(sharded_signal_testing, disconnect_in_emit)
+{
+    using connection = signals::sharded_signal<void ()>::connection;
+    signals::sharded_signal<void ()> sig(four_shards());
+    std::atomic<int> got1{0};
+    std::atomic<int> got2{0};
+    connection conn1, conn2, conn3, later;
+    conn1 = sig.connect(2, [&] { ++got1; });
+    conn2 = sig.connect(2, [&] { ++got2; conn1.disconnect(); conn2.disconnect(); });
+    // connecting on the shard running the slot is fine
+    conn3 = sig.connect(2, [&] { later = sig.connect(2, [] {}); });
+
+    sig();
+    sig();
+    EXPECT_EQ(0, got1);
+    EXPECT_EQ(1, got2);
+}
+
+TEST(sharded_signal_testing, local_shard)
+{
+    signals::sharded_signal<void ()> sig(signals::shard_by::core);
+    EXPECT_EQ(signals::detail::allowed_cpus().size(), sig.shard_count());
+    std::atomic<int> got{0};
+    auto conn = sig.connect([&] { ++got; });
+    EXPECT_EQ(sig.local_shard(), conn.shard_index());
+    auto moved = std::move(conn);
+
+    sig();
+    EXPECT_EQ(1, got);
+    EXPECT_LE(1u, signals::sharded_signal<void ()>().shard_count());
+}
+
+TEST(sharded_signal_testing, connect_while_emitting)
+{
+    using connection = signals::sharded_signal<void (int)>::connection;
+    signals::sharded_signal<void (int)> sig(four_shards());
+    std::atomic<long> sum{0};
+    auto conn = sig.connect(1, [&](int v) { sum += v; });
+    std::atomic<bool> done{false};
+    std::thread churn([&]
+    {
+        std::vector<connection> conns(16);
+        for (std::size_t i = 0; !done; i++)
+            conns[i % conns.size()] = sig.connect(i % 4, [](int) {});
+    });
+
+    for (int i = 0; i < 2000; i++)
+        sig(1);
+    done = true;
+    churn.join();
+    EXPECT_EQ(2000, sum);
+}
+#endif
+
 int main(int argc, char** argv)
 {
     testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace signals
+{
+namespace detail
+{
+
+/* fixed size node allocator, memory is taken from chunks of ChunkSize nodes
+ * and recycled through an intrusive free list, chunks are released only on destruction */
+template <typename T, std::size_t ChunkSize = 64>
+class slab_pool
+{
+private:
+    union node
+    {
+        node* next;
+        alignas(T) unsigned char value[sizeof(T)];
+    };
+
+    std::vector<std::unique_ptr<node[]>> chunks;
+    node* free_list = nullptr;
+
+    void grow()
+    {
+        chunks.push_back(std::make_unique<node[]>(ChunkSize));
+        auto* chunk = chunks.back().get();
+        for (std::size_t i = ChunkSize; i-- > 0;)
+        {
+            chunk[i].next = free_list;
+            free_list = &chunk[i];
+        }
+    }
+public:
+    slab_pool() = default;
+    slab_pool(slab_pool const&) = delete;
+    slab_pool& operator=(slab_pool const&) = delete;
+
+    void* allocate()
+    {
+        if (free_list == nullptr)
+            grow();
+        auto* n = free_list;
+        free_list = n->next;
+        return n->value;
+    }
+
+    void deallocate(void* p) noexcept
+    {
+        auto* n = reinterpret_cast<node*>(p);
+        n->next = free_list;
+        free_list = n;
+    }
+};
+
+}
+}
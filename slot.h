@@ -0,0 +1,274 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace signals
+{
+
+inline constexpr std::size_t default_inline_bytes = 5 * sizeof(void*);
+
+// how an emitted argument reaches the slots: by reference, never by copy
+template <typename T>
+using arg_ref = std::add_lvalue_reference_t<std::add_const_t<T>>;
+
+namespace detail
+{
+    template <typename T>
+    inline constexpr bool expensive_copy = !std::is_reference_v<T>
+            && !(std::is_trivially_copyable_v<T> && sizeof(T) <= 2 * sizeof(void*));
+
+    template <typename... P>
+    struct params_copy : std::bool_constant<(expensive_copy<P> || ...)>
+    {};
+
+    template <typename F, typename = void>
+    struct call_operator_copies : std::false_type
+    {};
+    template <typename F>
+    struct call_operator_copies<F, std::void_t<decltype(&F::operator())>>
+            : call_operator_copies<decltype(&F::operator())>
+    {};
+    template <typename R, typename... P>
+    struct call_operator_copies<R (*)(P...)> : params_copy<P...>
+    {};
+    template <typename R, typename... P>
+    struct call_operator_copies<R (*)(P...) noexcept> : params_copy<P...>
+    {};
+    template <typename R, typename C, typename... P>
+    struct call_operator_copies<R (C::*)(P...)> : params_copy<P...>
+    {};
+    template <typename R, typename C, typename... P>
+    struct call_operator_copies<R (C::*)(P...) const> : params_copy<P...>
+    {};
+    template <typename R, typename C, typename... P>
+    struct call_operator_copies<R (C::*)(P...) noexcept> : params_copy<P...>
+    {};
+    template <typename R, typename C, typename... P>
+    struct call_operator_copies<R (C::*)(P...) const noexcept> : params_copy<P...>
+    {};
+}
+
+/* true when F takes an argument by value that is not trivially copyable or larger than two pointers,
+ * generic and overloaded callables can not be inspected and are reported as not copying */
+template <typename F>
+inline constexpr bool copies_arguments_v = detail::call_operator_copies<std::decay_t<F>>::value;
+
+template <typename T, std::size_t InlineBytes = default_inline_bytes>
+class slot;
+
+/* type-erased callable with an inline buffer of InlineBytes
+ * callables that fit the buffer and are nothrow movable never allocate,
+ * the rest are kept on heap and moved by pointer, so move is always noexcept.
+ * slot<R(Args...) noexcept> only accepts callables that can not throw and calls them
+ * through a noexcept function pointer */
+template <typename R, typename... Args, bool Nothrow, std::size_t InlineBytes>
+class slot<R (Args...) noexcept(Nothrow), InlineBytes>
+{
+private:
+    static constexpr std::size_t buffer_size = InlineBytes < sizeof(void*) ? sizeof(void*) : InlineBytes;
+
+    struct ops_table
+    {
+        void (*relocate)(slot& to, slot& from) noexcept;
+        void (*destroy)(slot& s) noexcept;
+        R (*consume)(void* storage, Args&&...) noexcept(Nothrow);
+        R (*call)(void* storage, arg_ref<Args>...) noexcept(Nothrow);
+    };
+
+    R (*invoke)(void* storage, arg_ref<Args>...) noexcept(Nothrow) = nullptr;
+    ops_table const* ops = nullptr;
+    alignas(void*) unsigned char storage[buffer_size];
+
+    template <typename F>
+    static constexpr bool is_inline = sizeof(F) <= buffer_size
+            && alignof(F) <= alignof(void*)
+            && std::is_nothrow_move_constructible_v<F>;
+
+    template <typename F>
+    F* inline_target() noexcept
+    {
+        return std::launder(reinterpret_cast<F*>(storage));
+    }
+    template <typename F>
+    F*& heap_target() noexcept
+    {
+        return *std::launder(reinterpret_cast<F**>(storage));
+    }
+
+    template <typename F>
+    static constexpr bool accepts = Nothrow
+            ? std::is_nothrow_invocable_r_v<R, F&, arg_ref<Args>...>
+                    && (!std::is_invocable_v<F&, Args&&...> || std::is_nothrow_invocable_r_v<R, F&, Args&&...>)
+            : std::is_invocable_r_v<R, F&, arg_ref<Args>...>;
+
+    template <typename F>
+    struct inline_model
+    {
+        static R call(void* s, arg_ref<Args>... a) noexcept(Nothrow)
+        {
+            return (*static_cast<F*>(s))(a...);
+        }
+        static R consume(void* s, Args&&... a) noexcept(Nothrow)
+        {
+            return forward_to(*static_cast<F*>(s), std::forward<Args>(a)...);
+        }
+        static void relocate(slot& to, slot& from) noexcept
+        {
+            F* src = from.inline_target<F>();
+            ::new (static_cast<void*>(to.storage)) F(std::move(*src));
+            src->~F();
+        }
+        static void destroy(slot& s) noexcept
+        {
+            s.inline_target<F>()->~F();
+        }
+        static constexpr ops_table table = {&relocate, &destroy, &consume, &call};
+    };
+
+    template <typename F>
+    struct heap_model
+    {
+        static R call(void* s, arg_ref<Args>... a) noexcept(Nothrow)
+        {
+            return (**static_cast<F**>(s))(a...);
+        }
+        static R consume(void* s, Args&&... a) noexcept(Nothrow)
+        {
+            return forward_to(**static_cast<F**>(s), std::forward<Args>(a)...);
+        }
+        static void relocate(slot& to, slot& from) noexcept
+        {
+            ::new (static_cast<void*>(to.storage)) F*(from.heap_target<F>());
+        }
+        static void destroy(slot& s) noexcept
+        {
+            delete s.heap_target<F>();
+        }
+        static constexpr ops_table table = {&relocate, &destroy, &consume, &call};
+    };
+
+    // slots taking lvalue references can not be given rvalues, they see the arguments in place
+    template <typename F>
+    static R forward_to(F& f, Args&&... a) noexcept(Nothrow)
+    {
+        if constexpr (std::is_invocable_v<F&, Args&&...>)
+            return f(std::forward<Args>(a)...);
+        else
+            return f(a...);
+    }
+
+    void steal(slot& r) noexcept
+    {
+        if (r.ops == nullptr)
+            return;
+        r.ops->relocate(*this, r);
+        invoke = r.invoke;
+        ops = r.ops;
+        r.invoke = nullptr;
+        r.ops = nullptr;
+    }
+
+public:
+    template <typename F>
+    static constexpr bool fits_inline = is_inline<std::decay_t<F>>;
+
+    slot() noexcept = default;
+    slot(std::nullptr_t) noexcept {}
+
+    template <typename F,
+              typename Fn = std::decay_t<F>,
+              typename = std::enable_if_t<!std::is_same_v<Fn, slot> && accepts<Fn>>>
+    slot(F&& f)
+    {
+        if constexpr (std::is_pointer_v<Fn> || std::is_member_pointer_v<Fn>)
+        {
+            if (f == nullptr)
+                return;
+        }
+        if constexpr (is_inline<Fn>)
+        {
+            ::new (static_cast<void*>(storage)) Fn(std::forward<F>(f));
+            invoke = &inline_model<Fn>::call;
+            ops = &inline_model<Fn>::table;
+        }
+        else
+        {
+            ::new (static_cast<void*>(storage)) Fn*(new Fn(std::forward<F>(f)));
+            invoke = &heap_model<Fn>::call;
+            ops = &heap_model<Fn>::table;
+        }
+    }
+
+    slot(slot const&) = delete;
+    slot(slot&& r) noexcept
+    {
+        steal(r);
+    }
+
+    slot& operator=(slot const&) = delete;
+    slot& operator=(slot&& r) noexcept
+    {
+        if (this == &r)
+            return *this;
+        reset();
+        steal(r);
+        return *this;
+    }
+
+    ~slot()
+    {
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        if (ops == nullptr)
+            return;
+        auto o = ops;
+        invoke = nullptr;
+        ops = nullptr;
+        o->destroy(*this);
+    }
+
+    // false for an empty or a blocked slot
+    explicit operator bool() const noexcept
+    {
+        return invoke != nullptr;
+    }
+
+    // a blocked slot keeps its callable and tests false until unblock()
+    void block() noexcept
+    {
+        invoke = nullptr;
+    }
+
+    void unblock() noexcept
+    {
+        if (ops != nullptr)
+            invoke = ops->call;
+    }
+
+    bool blocked() const noexcept
+    {
+        return invoke == nullptr && ops != nullptr;
+    }
+
+    R operator()(arg_ref<Args>... a) noexcept(Nothrow)
+    {
+        assert(invoke != nullptr);
+        return invoke(storage, a...);
+    }
+
+    // passes the arguments as rvalues, slots taking them by value get them moved in
+    R consume(Args&&... a) noexcept(Nothrow)
+    {
+        assert(invoke != nullptr);
+        return ops->consume(storage, std::forward<Args>(a)...);
+    }
+};
+
+}
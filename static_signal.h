@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "slot.h"
+
+namespace signals
+{
+
+template <typename T, typename... Slots>
+struct static_signal;
+
+/* signal whose slots are fixed by its type
+ * they are stored by value in a tuple and called in order by a fold expression,
+ * there is no type erasure and no list, so every call can be inlined.
+ * emits like signal<void(Args...)>, but slots run in the order they are listed */
+template <typename... Args, typename... Slots>
+struct static_signal<void (Args...), Slots...>
+{
+    static_assert((std::is_invocable_v<Slots&, arg_ref<Args>...> && ...),
+                  "every slot has to be callable with the signal arguments");
+
+    static constexpr std::size_t size = sizeof...(Slots);
+
+    static_signal() = default;
+
+    explicit static_signal(Slots... slots)
+    : slots(std::move(slots)...)
+    {}
+
+    void operator()(arg_ref<Args>... a)
+    {
+        std::apply([&](Slots&... s) { (static_cast<void>(s(a...)), ...); }, slots);
+    }
+
+    template <std::size_t I>
+    auto& get() noexcept
+    {
+        return std::get<I>(slots);
+    }
+
+private:
+    std::tuple<Slots...> slots;
+};
+
+// static_signal<void(Args...), decltype(fs)...> holding copies of fs
+template <typename Signature, typename... Fs>
+static_signal<Signature, std::decay_t<Fs>...> make_static_signal(Fs&&... fs)
+{
+    return static_signal<Signature, std::decay_t<Fs>...>(std::forward<Fs>(fs)...);
+}
+
+}
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+/* timeline of emissions and slot calls, an instrumentation for Policy::instrumentation
+ *
+ * every thread appends complete spans to its own ring buffer, the emit path takes no lock
+ * and does not allocate once the thread's ring exists. dump_chrome_trace writes all rings
+ * in the chrome trace event format, which chrome://tracing and the perfetto ui both load.
+ * spans carry the signal (its name if one was set, its address otherwise), the connection
+ * of a slot and the emission nesting depth on that thread */
+namespace signals
+{
+
+struct tracing_instrumentation
+{
+    static constexpr std::size_t ring_size = 1 << 14;
+
+    struct event
+    {
+        std::uint64_t begin_ns;
+        std::uint64_t end_ns;
+        void const* signal;
+        char const* name;
+        // connection for slot spans, null for emissions
+        void const* slot;
+        // emissions of any signal the span is nested in, a slot is at the depth of its emission
+        std::uint32_t depth;
+    };
+
+    // shown instead of the address, has to outlive the dump
+    char const* name = nullptr;
+
+private:
+    struct ring
+    {
+        std::uint32_t thread;
+        std::uint32_t depth = 0;
+        // events written so far, the last ring_size of them are kept
+        std::atomic<std::uint64_t> written{0};
+        std::unique_ptr<event[]> events = std::make_unique<event[]>(ring_size);
+
+        explicit ring(std::uint32_t thread) noexcept
+        : thread(thread)
+        {}
+
+        void push(event const& e) noexcept
+        {
+            auto n = written.load(std::memory_order_relaxed);
+            events[n % ring_size] = e;
+            written.store(n + 1, std::memory_order_release);
+        }
+    };
+
+    // rings stay until exit, so the spans of finished threads can still be dumped
+    struct registry
+    {
+        std::mutex m;
+        std::vector<std::unique_ptr<ring>> rings;
+    };
+
+    static registry& all() noexcept
+    {
+        static registry r;
+        return r;
+    }
+
+    static ring& local()
+    {
+        thread_local ring* r = []
+        {
+            auto& reg = all();
+            std::lock_guard<std::mutex> lock(reg.m);
+            reg.rings.push_back(std::make_unique<ring>(std::uint32_t(reg.rings.size())));
+            return reg.rings.back().get();
+        }();
+        return *r;
+    }
+
+    static std::uint64_t now() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // the format counts in microseconds
+    static void write_us(std::ostream& out, std::uint64_t ns)
+    {
+        out << ns / 1000 << '.' << char('0' + ns / 100 % 10) << char('0' + ns / 10 % 10) << char('0' + ns % 10);
+    }
+
+    static void write_string(std::ostream& out, char const* s)
+    {
+        out << '"';
+        for (; *s != '\0'; ++s)
+        {
+            if (*s == '"' || *s == '\\')
+                out << '\\';
+            if (static_cast<unsigned char>(*s) >= 0x20)
+                out << *s;
+        }
+        out << '"';
+    }
+
+public:
+    struct emit_scope
+    {
+        ring* r;
+        event e;
+
+        emit_scope(tracing_instrumentation const* self, ring& r) noexcept
+        : r(&r)
+        , e{now(), 0, self, self->name, nullptr, r.depth++}
+        {}
+        ~emit_scope()
+        {
+            r->depth--;
+            e.end_ns = now();
+            r->push(e);
+        }
+
+        emit_scope(emit_scope const&) = delete;
+        emit_scope& operator=(emit_scope const&) = delete;
+    };
+
+    struct token
+    {
+        std::uint64_t begin_ns;
+        void const* slot;
+    };
+
+    emit_scope on_emit()
+    {
+        return emit_scope(this, local());
+    }
+    token on_slot_begin(void const* slot) noexcept
+    {
+        return {now(), slot};
+    }
+    void on_slot_end(token t) noexcept
+    {
+        auto& r = local();
+        r.push({t.begin_ns, now(), this, name, t.slot, r.depth - 1});
+    }
+    void on_disconnect_in_emit() noexcept
+    {}
+    void on_move_in_emit() noexcept
+    {}
+
+    /* threads may keep emitting while this runs, their oldest spans may then be
+     * overwritten while being read */
+    template <typename Visit>
+    static void visit_events(Visit&& visit)
+    {
+        auto& reg = all();
+        std::lock_guard<std::mutex> lock(reg.m);
+        for (auto& r : reg.rings)
+        {
+            auto end = r->written.load(std::memory_order_acquire);
+            auto begin = end > ring_size ? end - ring_size : 0;
+            for (auto i = begin; i < end; i++)
+                visit(r->thread, r->events[i % ring_size]);
+        }
+    }
+
+    // forgets every recorded span, no thread may be emitting
+    static void clear()
+    {
+        visit_rings([](ring& r) { r.written.store(0, std::memory_order_relaxed); });
+    }
+
+    static void dump_chrome_trace(std::ostream& out)
+    {
+        out << "{\"traceEvents\":[";
+        bool first = true;
+        visit_events([&](std::uint32_t thread, event const& e)
+        {
+            if (!first)
+                out << ',';
+            first = false;
+            out << "\n{\"name\":";
+            if (e.name != nullptr)
+                write_string(out, e.name);
+            else
+                out << "\"signal " << e.signal << '"';
+            out << ",\"cat\":\"" << (e.slot == nullptr ? "emit" : "slot") << '"'
+                << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread
+                << ",\"ts\":";
+            write_us(out, e.begin_ns);
+            out << ",\"dur\":";
+            write_us(out, e.end_ns - e.begin_ns);
+            out << ",\"args\":{\"signal\":\"" << e.signal << "\",\"depth\":" << e.depth;
+            if (e.slot != nullptr)
+                out << ",\"slot\":\"" << e.slot << '"';
+            out << "}}";
+        });
+        out << "\n]}\n";
+    }
+
+private:
+    template <typename Visit>
+    static void visit_rings(Visit&& visit)
+    {
+        auto& reg = all();
+        std::lock_guard<std::mutex> lock(reg.m);
+        for (auto& r : reg.rings)
+            visit(*r);
+    }
+};
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+
+#include "intrusive_list.h"
+
+namespace signals
+{
+
+template <typename T, std::size_t InlineBytes, typename Policy>
+struct signal;
+
+namespace detail
+{
+
+struct tracking_tag;
+
+// linked into the tracked object, release tears down whatever the hook belongs to
+struct tracking_hook : intrusive::list_element<tracking_tag>
+{
+    void (*release)(tracking_hook* self) noexcept;
+
+    explicit tracking_hook(void (*release)(tracking_hook*) noexcept) noexcept
+    : release(release)
+    {}
+};
+
+}
+
+/* base of objects whose lifetime bounds connections, see signal::connect_tracked
+ * the destructor disconnects every connection tracking the object, so the slots
+ * never have to check whether it is still alive. copies track nothing */
+class trackable
+{
+private:
+    template <typename T, std::size_t InlineBytes, typename Policy>
+    friend struct signal;
+
+    intrusive::list<detail::tracking_hook, detail::tracking_tag> hooks;
+
+    void track(detail::tracking_hook& hook) noexcept
+    {
+        hooks.push_back(hook);
+    }
+protected:
+    trackable() = default;
+    trackable(trackable const&) noexcept
+    {}
+    trackable& operator=(trackable const&) noexcept
+    {
+        return *this;
+    }
+
+    ~trackable()
+    {
+        disconnect_tracked();
+    }
+
+    void disconnect_tracked() noexcept
+    {
+        while (!hooks.empty())
+        {
+            auto& hook = hooks.front();
+            hooks.pop_front();
+            hook.release(&hook);
+        }
+    }
+};
+
+}
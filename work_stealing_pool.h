@@ -0,0 +1,207 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace signals
+{
+
+/* fixed set of worker threads running index ranges
+ *
+ * run(count, fn) splits [0, count) into one range per participant, the calling thread
+ * included. a participant takes indices from the front of its own range and, once it
+ * is empty, steals the back half of someone else's. a range is one atomic word, so
+ * both are a single compare-exchange. run returns after every index was processed */
+class work_stealing_pool
+{
+private:
+    struct alignas(64) range
+    {
+        // begin in the low half, end in the high half
+        std::atomic<std::uint64_t> bounds{0};
+
+        static std::uint64_t pack(std::uint32_t begin, std::uint32_t end) noexcept
+        {
+            return (std::uint64_t(end) << 32) | begin;
+        }
+    };
+
+    struct job
+    {
+        void (*invoke)(void* fn, std::size_t index);
+        void* fn;
+        std::unique_ptr<range[]> ranges;
+        std::size_t participants;
+        std::atomic<std::size_t> remaining;
+    };
+
+    std::vector<std::thread> workers;
+    std::mutex running;
+    std::mutex m;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    job* current = nullptr;
+    std::uint64_t generation = 0;
+    std::size_t active = 0;
+    bool stopping = false;
+
+    static bool pop_front(range& r, std::uint32_t& index) noexcept
+    {
+        auto cur = r.bounds.load(std::memory_order_acquire);
+        for (;;)
+        {
+            auto begin = std::uint32_t(cur);
+            auto end = std::uint32_t(cur >> 32);
+            if (begin >= end)
+                return false;
+            if (r.bounds.compare_exchange_weak(cur, range::pack(begin + 1, end), std::memory_order_acq_rel))
+            {
+                index = begin;
+                return true;
+            }
+        }
+    }
+
+    static bool steal_half(range& victim, range& into) noexcept
+    {
+        auto cur = victim.bounds.load(std::memory_order_acquire);
+        for (;;)
+        {
+            auto begin = std::uint32_t(cur);
+            auto end = std::uint32_t(cur >> 32);
+            if (begin >= end)
+                return false;
+            auto mid = begin + (end - begin) / 2;
+            if (victim.bounds.compare_exchange_weak(cur, range::pack(begin, mid), std::memory_order_acq_rel))
+            {
+                into.bounds.store(range::pack(mid, end), std::memory_order_release);
+                return true;
+            }
+        }
+    }
+
+    static void participate(job& j, std::size_t self) noexcept
+    {
+        auto& own = j.ranges[self];
+        for (;;)
+        {
+            std::uint32_t index;
+            while (pop_front(own, index))
+            {
+                j.invoke(j.fn, index);
+                j.remaining.fetch_sub(1, std::memory_order_acq_rel);
+            }
+
+            bool stolen = false;
+            for (std::size_t i = 1; i < j.participants && !stolen; i++)
+                stolen = steal_half(j.ranges[(self + i) % j.participants], own);
+            if (!stolen)
+                return;
+        }
+    }
+
+    void work(std::size_t self)
+    {
+        std::uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(m);
+        for (;;)
+        {
+            wake.wait(lock, [&] { return stopping || (current != nullptr && generation != seen); });
+            if (stopping)
+                return;
+            seen = generation;
+            auto* j = current;
+            ++active;
+            lock.unlock();
+
+            participate(*j, self);
+
+            lock.lock();
+            if (--active == 0)
+                idle.notify_all();
+        }
+    }
+
+public:
+    explicit work_stealing_pool(std::size_t threads = std::max(1u, std::thread::hardware_concurrency()) - 1)
+    {
+        workers.reserve(threads);
+        for (std::size_t i = 0; i < threads; i++)
+            workers.emplace_back([this, i] { work(i + 1); });
+    }
+
+    work_stealing_pool(work_stealing_pool const&) = delete;
+    work_stealing_pool& operator=(work_stealing_pool const&) = delete;
+
+    ~work_stealing_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : workers)
+            t.join();
+    }
+
+    std::size_t participants() const noexcept
+    {
+        return workers.size() + 1;
+    }
+
+    /* fn(index) must not throw, it is called concurrently from several threads.
+     * while another run is in progress, from fn or from another thread, the indices
+     * are processed by the calling thread alone */
+    template <typename F>
+    void run(std::size_t count, F& fn)
+    {
+        if (count == 0)
+            return;
+        std::unique_lock<std::mutex> exclusive(running, std::try_to_lock);
+        if (!exclusive.owns_lock())
+        {
+            for (std::size_t i = 0; i < count; i++)
+                fn(i);
+            return;
+        }
+
+        job j;
+        j.invoke = [](void* f, std::size_t index) { (*static_cast<F*>(f))(index); };
+        j.fn = &fn;
+        j.participants = participants();
+        j.ranges = std::make_unique<range[]>(j.participants);
+        j.remaining.store(count, std::memory_order_relaxed);
+        for (std::size_t i = 0; i < j.participants; i++)
+        {
+            auto begin = count * i / j.participants;
+            auto end = count * (i + 1) / j.participants;
+            j.ranges[i].bounds.store(range::pack(std::uint32_t(begin), std::uint32_t(end)), std::memory_order_relaxed);
+        }
+
+        if (!workers.empty())
+        {
+            std::lock_guard<std::mutex> lock(m);
+            current = &j;
+            ++generation;
+        }
+        wake.notify_all();
+
+        participate(j, 0);
+        while (j.remaining.load(std::memory_order_acquire) != 0)
+            std::this_thread::yield();
+
+        // workers that did not pick the job up yet must not see it anymore
+        std::unique_lock<std::mutex> lock(m);
+        current = nullptr;
+        idle.wait(lock, [&] { return active == 0; });
+    }
+};
+
+}